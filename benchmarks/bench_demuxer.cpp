@@ -0,0 +1,282 @@
+/**
+ * @file bench_demuxer.cpp
+ * @brief Demuxer throughput benchmark
+ *
+ * Feeds a synthetic multi-PID transport stream held in memory and reports
+ * the best packets/s over several runs. Usage:
+ *
+ *   bench_demuxer [pid_count] [packet_count] [runs] [kept_pids] [fixed] [prefetch] [reference]
+ *
+ * With kept_pids > 0 a program table selecting the first kept_pids PIDs
+ * is set, so the remaining PIDs exercise the filtered path. With "fixed"
+ * the demuxer is instantiated with TSPacketSize instead of the default
+ * AutoPacketSize policy. prefetch sets DemuxerConfig::prefetch_distance
+ * (0 disables prefetching). With "reference" the stream is fed as one
+ * IngestBlock through feedBlock(), so payloads are referenced instead of
+ * copied.
+ *
+ * On Linux, cache misses per packet are read from the hardware
+ * performance counters (perf_event_open) when the kernel allows it.
+ */
+
+#include "mpegts_demuxer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace mpegts;
+
+namespace {
+
+/**
+ * @brief Hardware cache miss counters of this process (user space only)
+ */
+class PerfCounters {
+public:
+    enum Counter { LLC_MISSES, L1D_MISSES, COUNTER_COUNT };
+
+    PerfCounters() {
+        for (int& fd : fds_) {
+            fd = -1;
+        }
+#ifdef __linux__
+        fds_[LLC_MISSES] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds_[L1D_MISSES] = open(PERF_TYPE_HW_CACHE,
+                                PERF_COUNT_HW_CACHE_L1D |
+                                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    bool available(Counter counter) const { return fds_[counter] >= 0; }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    uint64_t read(Counter counter) const {
+        uint64_t value = 0;
+#ifdef __linux__
+        if (fds_[counter] < 0 || ::read(fds_[counter], &value, sizeof(value)) != sizeof(value)) {
+            return 0;
+        }
+#endif
+        return value;
+    }
+
+private:
+    int fds_[COUNTER_COUNT];
+
+#ifdef __linux__
+    static int open(uint32_t type, uint64_t config) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+};
+
+// Packets per PES-like unit: every Nth packet of a PID sets PUSI
+constexpr size_t PACKETS_PER_UNIT = 32;
+
+/**
+ * @brief Build a stream cycling over pid_count elementary PIDs
+ */
+std::vector<uint8_t> buildStream(size_t pid_count, size_t packet_count) {
+    std::vector<uint8_t> stream(packet_count * MPEGTS_PACKET_SIZE);
+    std::vector<uint8_t> cc(pid_count, 0);
+    std::vector<size_t> sent(pid_count, 0);
+
+    for (size_t i = 0; i < packet_count; ++i) {
+        size_t index = i % pid_count;
+        uint16_t pid = static_cast<uint16_t>(0x100 + index);
+        uint8_t* packet = &stream[i * MPEGTS_PACKET_SIZE];
+
+        bool pusi = (sent[index]++ % PACKETS_PER_UNIT) == 0;
+
+        packet[0] = MPEGTS_SYNC_BYTE;
+        packet[1] = static_cast<uint8_t>((pusi ? 0x40 : 0x00) | ((pid >> 8) & 0x1F));
+        packet[2] = static_cast<uint8_t>(pid & 0xFF);
+        packet[3] = static_cast<uint8_t>(0x10 | cc[index]); // Payload only
+        cc[index] = (cc[index] + 1) & 0x0F;
+
+        std::fill(packet + 4, packet + MPEGTS_PACKET_SIZE, static_cast<uint8_t>(i));
+    }
+
+    return stream;
+}
+
+/**
+ * @brief Feed the stream runs times to a fresh demuxer (through feedBlock()
+ *        when block is set)
+ * @return Best run time in seconds
+ */
+template <typename Demuxer>
+double runDemuxer(const std::vector<uint8_t>& stream, IngestBlock* block,
+                  size_t packet_count, size_t runs, size_t kept_pids, size_t pid_count,
+                  const DemuxerConfig& config, bool& synchronized) {
+    double best_seconds = 0.0;
+    PerfCounters counters;
+
+    if (!counters.available(PerfCounters::LLC_MISSES) &&
+        !counters.available(PerfCounters::L1D_MISSES)) {
+        std::cout << "(hardware performance counters unavailable)\n";
+    }
+
+    ProgramTable table;
+    for (size_t i = 0; i < std::min(kept_pids, pid_count); ++i) {
+        table.programs[1].push_back(static_cast<uint16_t>(0x100 + i));
+    }
+
+    for (size_t run = 0; run < runs; ++run) {
+        Demuxer demuxer(config);
+        if (kept_pids > 0) {
+            demuxer.setProgramsTable(table);
+        }
+
+        counters.start();
+        auto start = std::chrono::steady_clock::now();
+        if (block) {
+            demuxer.feedBlock(PayloadBlockRef(block), block->data(), block->capacity());
+        } else {
+            demuxer.feedData(stream.data(), stream.size());
+        }
+        auto end = std::chrono::steady_clock::now();
+        counters.stop();
+
+        synchronized = demuxer.isSynchronized();
+        if (!synchronized) {
+            return 0.0;
+        }
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (run == 0 || seconds < best_seconds) {
+            best_seconds = seconds;
+        }
+
+        std::cout << "Run " << (run + 1) << ": " << std::fixed << std::setprecision(2)
+                  << (packet_count / seconds / 1e6) << " Mpackets/s";
+        if (counters.available(PerfCounters::LLC_MISSES)) {
+            std::cout << ", " << std::setprecision(3)
+                      << double(counters.read(PerfCounters::LLC_MISSES)) / packet_count
+                      << " cache misses/packet";
+        }
+        if (counters.available(PerfCounters::L1D_MISSES)) {
+            std::cout << ", " << std::setprecision(3)
+                      << double(counters.read(PerfCounters::L1D_MISSES)) / packet_count
+                      << " L1D misses/packet";
+        }
+        std::cout << "\n";
+    }
+
+    return best_seconds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t pid_count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 16;
+    size_t packet_count = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 200000;
+    size_t runs = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 5;
+    size_t kept_pids = (argc > 4) ? std::strtoul(argv[4], nullptr, 10) : 0;
+    bool fixed_size = (argc > 5) && std::strcmp(argv[5], "fixed") == 0;
+    bool reference = (argc > 7) && std::strcmp(argv[7], "reference") == 0;
+
+    // Steady-state throughput only: round-robin PIDs never put consecutive
+    // packets of one PID on the grid, so lock on the first valid packet
+    DemuxerConfig config;
+    config.sync_acquire_count = 1;
+    if (argc > 6) {
+        config.prefetch_distance = static_cast<uint8_t>(std::strtoul(argv[6], nullptr, 10));
+    }
+
+    pid_count = std::max<size_t>(pid_count, 1);
+    runs = std::max<size_t>(runs, 1);
+
+    auto stream = buildStream(pid_count, packet_count);
+
+    IngestBlock* block = nullptr;
+    PayloadBlockRef block_ref;
+    if (reference) {
+        block = new IngestBlock(stream.size());
+        block_ref = PayloadBlockRef(block);
+        std::copy(stream.begin(), stream.end(), block->data());
+    }
+
+    std::cout << "Demuxer throughput: " << pid_count << " PIDs, "
+              << packet_count << " packets, " << runs << " runs";
+    if (kept_pids > 0) {
+        std::cout << ", " << kept_pids << " PIDs kept";
+    }
+    if (fixed_size) {
+        std::cout << ", fixed packet size";
+    }
+    std::cout << ", prefetch distance " << static_cast<int>(config.prefetch_distance);
+    if (reference) {
+        std::cout << ", payloads referenced";
+    }
+    std::cout << "\n";
+    std::cout << "----------------------------------------\n";
+
+    bool synchronized = false;
+    double best_seconds = fixed_size
+        ? runDemuxer<BasicDemuxer<TSPacketSize, AllPIDs, KeepAllPayloads>>(
+              stream, block, packet_count, runs, kept_pids, pid_count, config, synchronized)
+        : runDemuxer<MPEGTSDemuxer>(stream, block, packet_count, runs, kept_pids, pid_count,
+                                    config, synchronized);
+
+    if (!synchronized) {
+        std::cerr << "Error: demuxer did not synchronize\n";
+        return 1;
+    }
+
+    std::cout << "----------------------------------------\n";
+    std::cout << "Best: " << std::fixed << std::setprecision(2)
+              << (packet_count / best_seconds / 1e6) << " Mpackets/s ("
+              << (stream.size() / best_seconds / (1024.0 * 1024.0)) << " MB/s)\n";
+
+    return 0;
+}
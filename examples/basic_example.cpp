@@ -4,7 +4,7 @@
  *
  * This example demonstrates how to:
  * - Create a demuxer instance
- * - Feed data from a file
+ * - Feed a memory-mapped file
  * - Check synchronization status
  * - Retrieve discovered streams
  * - Access payload data
@@ -12,7 +12,6 @@
 
 #include "mpegts_demuxer.hpp"
 #include <iostream>
-#include <fstream>
 #include <iomanip>
 
 using namespace mpegts;
@@ -25,9 +24,9 @@ int main(int argc, char* argv[]) {
 
     const char* filename = argv[1];
 
-    // Open MPEG-TS file
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
+    // Map MPEG-TS file
+    MappedSource source;
+    if (!source.open(filename)) {
         std::cerr << "Error: Cannot open file " << filename << "\n";
         return 1;
     }
@@ -35,30 +34,18 @@ int main(int argc, char* argv[]) {
     // Create demuxer
     MPEGTSDemuxer demuxer;
 
-    // Feed data in chunks
-    const size_t CHUNK_SIZE = 4096;
-    uint8_t buffer[CHUNK_SIZE];
-
     std::cout << "Processing file: " << filename << "\n";
     std::cout << "----------------------------------------\n";
 
-    size_t total_bytes = 0;
-
-    while (file.read(reinterpret_cast<char*>(buffer), CHUNK_SIZE) || file.gcount() > 0) {
-        size_t bytes_read = file.gcount();
-        total_bytes += bytes_read;
-
-        demuxer.feedData(buffer, bytes_read);
+    // Packet-aligned windows are parsed straight from the mapping
+    size_t total_bytes = demuxer.feedFile(source);
 
-        // Check synchronization status
-        if (demuxer.isSynchronized()) {
-            std::cout << "\r✓ Synchronized | ";
-            std::cout << "Buffer: " << demuxer.getPacketCount() << " packets | ";
-            std::cout << "Bytes: " << total_bytes;
-            std::cout.flush();
-        }
+    // Check synchronization status
+    if (demuxer.isSynchronized()) {
+        std::cout << "✓ Synchronized | ";
+        std::cout << "Packet size: " << getPacketStride(demuxer.getPacketFormat()) << " | ";
+        std::cout << "Bytes: " << total_bytes;
     }
-
     std::cout << "\n----------------------------------------\n";
 
     // Get discovered programs/streams
@@ -0,0 +1,206 @@
+#ifndef MPEGTS_ARENA_HPP
+#define MPEGTS_ARENA_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace mpegts {
+
+/**
+ * @brief Reference-counted block of payload memory
+ *
+ * Payload segments keep the block their bytes live in referenced through
+ * PayloadBlockRef; what happens to an unreferenced block is up to the
+ * subclass. Counts are not atomic: a block belongs to one demuxer.
+ */
+class PayloadBlock {
+public:
+    PayloadBlock(const PayloadBlock&) = delete;
+    PayloadBlock& operator=(const PayloadBlock&) = delete;
+
+    /**
+     * @brief Get number of references
+     */
+    uint32_t getRefCount() const { return refs_; }
+
+    void addRef() { ++refs_; }
+
+    void release() {
+        if (--refs_ == 0) {
+            onUnreferenced();
+        }
+    }
+
+protected:
+    PayloadBlock() : refs_(0) {}
+    virtual ~PayloadBlock() = default;
+
+    /**
+     * @brief Called when the last reference is released
+     */
+    virtual void onUnreferenced() = 0;
+
+private:
+    uint32_t refs_;
+};
+
+/**
+ * @brief Owning reference to a PayloadBlock (empty if none)
+ */
+class PayloadBlockRef {
+public:
+    PayloadBlockRef() : block_(nullptr) {}
+
+    explicit PayloadBlockRef(PayloadBlock* block)
+        : block_(block)
+    {
+        if (block_) {
+            block_->addRef();
+        }
+    }
+
+    PayloadBlockRef(const PayloadBlockRef& other)
+        : PayloadBlockRef(other.block_)
+    {}
+
+    PayloadBlockRef(PayloadBlockRef&& other) noexcept
+        : block_(std::exchange(other.block_, nullptr))
+    {}
+
+    PayloadBlockRef& operator=(PayloadBlockRef other) noexcept {
+        std::swap(block_, other.block_);
+        return *this;
+    }
+
+    ~PayloadBlockRef() { reset(); }
+
+    /**
+     * @brief Drop the reference
+     */
+    void reset() {
+        if (block_) {
+            std::exchange(block_, nullptr)->release();
+        }
+    }
+
+    PayloadBlock* get() const { return block_; }
+    explicit operator bool() const { return block_ != nullptr; }
+
+private:
+    PayloadBlock* block_;
+};
+
+/**
+ * @brief Heap block for ingest data fed with zero-copy referencing
+ *
+ * Allocate with new and hand it to a PayloadBlockRef straight away; the
+ * block deletes itself when the last reference goes:
+ *
+ *     auto* chunk = new IngestBlock(1 << 20);
+ *     PayloadBlockRef ref(chunk);
+ *     size_t n = read_stream(chunk->data(), chunk->capacity());
+ *     demuxer.feedBlock(ref, chunk->data(), n);
+ */
+class IngestBlock : public PayloadBlock {
+public:
+    explicit IngestBlock(size_t capacity)
+        : capacity_(capacity)
+        , bytes_(new uint8_t[capacity])
+    {}
+
+    uint8_t* data() { return bytes_.get(); }
+    const uint8_t* data() const { return bytes_.get(); }
+    size_t capacity() const { return capacity_; }
+
+protected:
+    void onUnreferenced() override { delete this; }
+
+private:
+    size_t                      capacity_;
+    std::unique_ptr<uint8_t[]>  bytes_;
+};
+
+/**
+ * @brief Bump allocator for iteration payloads
+ *
+ * Payload bytes are copied into large pages, one after another. A page
+ * is referenced by every segment stored in it and goes back to the
+ * arena's free list when the last of them is cleared or evicted, so a
+ * stream with a steady bitrate reuses the same pages and makes no
+ * allocator calls per packet. Segments larger than a page get a page of
+ * their own.
+ *
+ * Pages still referenced when the arena is destroyed are freed with
+ * their last reference.
+ */
+class PayloadArena {
+public:
+    static constexpr size_t DEFAULT_PAGE_SIZE = 64 * 1024;
+    static constexpr size_t DEFAULT_MAX_FREE_PAGES = 16;
+
+    /**
+     * @param page_size Page size in bytes
+     * @param max_free_pages Unreferenced pages kept for reuse; more are
+     *        returned to the system
+     */
+    explicit PayloadArena(size_t page_size = DEFAULT_PAGE_SIZE,
+                          size_t max_free_pages = DEFAULT_MAX_FREE_PAGES);
+    ~PayloadArena();
+
+    PayloadArena(const PayloadArena&) = delete;
+    PayloadArena& operator=(const PayloadArena&) = delete;
+
+    /**
+     * @brief Copy bytes into the arena
+     * @param data Source bytes
+     * @param length Number of bytes
+     * @param block Receives a reference to the page holding the copy
+     * @return Pointer to the copy, valid while block is referenced
+     */
+    const uint8_t* store(const uint8_t* data, size_t length, PayloadBlockRef& block) {
+        if (!current_ || length > static_cast<size_t>(limit_ - cursor_)) {
+            return storeInNewPage(data, length, block);
+        }
+
+        uint8_t* destination = cursor_;
+        std::memcpy(destination, data, length);
+        cursor_ += length;
+
+        block = current_;
+        return destination;
+    }
+
+    /**
+     * @brief Get page size in bytes
+     */
+    size_t getPageSize() const;
+
+    /**
+     * @brief Get number of pages allocated from the system so far
+     */
+    size_t getPageAllocations() const;
+
+    /**
+     * @brief Get number of unreferenced pages kept for reuse
+     */
+    size_t getFreePageCount() const;
+
+private:
+    class Page;
+    struct Pool;
+
+    std::shared_ptr<Pool>   pool_;          ///< Shared with pages, which may outlive the arena
+    PayloadBlockRef         current_;       ///< Page being filled
+    uint8_t*                cursor_;        ///< Next free byte of the current page
+    uint8_t*                limit_;         ///< End of the current page
+
+    const uint8_t* storeInNewPage(const uint8_t* data, size_t length, PayloadBlockRef& block);
+    Page* takePage(size_t capacity);
+};
+
+} // namespace mpegts
+
+#endif // MPEGTS_ARENA_HPP
@@ -0,0 +1,143 @@
+#ifndef MPEGTS_BATCH_HPP
+#define MPEGTS_BATCH_HPP
+
+#include "mpegts_types.hpp"
+#include "mpegts_packet.hpp"
+#include "mpegts_sync.hpp"
+#include "mpegts_pid_state.hpp"
+#include <cstdint>
+#include <cstddef>
+
+namespace mpegts {
+
+// ============================================================================
+// Batch Header Decoder
+// ============================================================================
+
+constexpr size_t HEADER_BATCH_SIZE = 32;    // Maximum packets per batch
+
+/**
+ * @brief Decoded headers of a batch of packets, structure-of-arrays
+ *
+ * Per-packet fields are stored in parallel arrays; single-bit flags are
+ * packed into masks (bit i = packet i) so later stages can test a whole
+ * batch with one instruction.
+ */
+struct PacketHeaderBatch {
+    alignas(32) uint16_t pid[HEADER_BATCH_SIZE];                 ///< 13-bit PID
+    alignas(32) uint8_t  continuity_counter[HEADER_BATCH_SIZE];  ///< CC (4 bits)
+    alignas(32) uint8_t  adaptation_control[HEADER_BATCH_SIZE];  ///< AdaptationFieldControl value
+    alignas(32) uint8_t  scrambling_control[HEADER_BATCH_SIZE];  ///< Scrambling (2 bits)
+
+    uint32_t    sync_mask;          ///< Packet starts with the sync byte
+    uint32_t    tei_mask;           ///< transport_error_indicator set
+    uint32_t    pusi_mask;          ///< payload_unit_start_indicator set
+    uint32_t    priority_mask;      ///< transport_priority set
+    size_t      count;              ///< Number of decoded packets
+
+    PacketHeaderBatch()
+        : sync_mask(0)
+        , tei_mask(0)
+        , pusi_mask(0)
+        , priority_mask(0)
+        , count(0)
+    {}
+
+    /**
+     * @brief Get the decoded header of packet i as a TSPacketHeader
+     */
+    TSPacketHeader header(size_t i) const {
+        const uint32_t bit = uint32_t(1) << i;
+
+        TSPacketHeader header;
+        header.sync_byte = (sync_mask & bit) ? MPEGTS_SYNC_BYTE : 0;
+        header.transport_error_indicator = (tei_mask & bit) != 0;
+        header.payload_unit_start = (pusi_mask & bit) != 0;
+        header.transport_priority = (priority_mask & bit) != 0;
+        header.pid = pid[i];
+        header.scrambling_control = scrambling_control[i];
+        header.adaptation_control = static_cast<AdaptationFieldControl>(adaptation_control[i]);
+        header.continuity_counter = continuity_counter[i];
+        return header;
+    }
+};
+
+/**
+ * @brief Decode the headers of up to HEADER_BATCH_SIZE packets
+ *
+ * Header words of eight packets are gathered into one vector and split
+ * into fields with byte shuffles, so the batch is decoded without a
+ * branch per packet. Packets without the sync byte are decoded as well;
+ * check sync_mask before trusting the other fields.
+ *
+ * @param data Pointer to the sync byte of the first packet
+ * @param n Number of packets available (at data + i * stride)
+ * @param batch Receives the decoded fields
+ * @param stride Distance between packets
+ * @return Number of packets decoded (min(n, HEADER_BATCH_SIZE))
+ */
+size_t decodeHeaders(const uint8_t* data, size_t n, PacketHeaderBatch& batch,
+                     size_t stride = MPEGTS_PACKET_SIZE);
+
+/**
+ * @brief Same as decodeHeaders(), using a specific kernel
+ *
+ * The kernel must be supported by the CPU. Kernels without a vector
+ * gather (SSE2) decode with the scalar code.
+ */
+size_t decodeHeaders(SyncScanKernel kernel, const uint8_t* data, size_t n,
+                     PacketHeaderBatch& batch, size_t stride = MPEGTS_PACKET_SIZE);
+
+// ============================================================================
+// Batch Continuity Check
+// ============================================================================
+
+/**
+ * @brief Continuity counter verdicts for a batch (bit i = packet i)
+ *
+ * Only packets whose PID already had a counter are judged; the first
+ * packet of a PID sets the reference and is in none of the masks.
+ */
+struct ContinuityResult {
+    uint32_t    error_mask;             ///< Unexpected CC, not signalled
+    uint32_t    duplicate_mask;         ///< Payload packet repeating the previous CC (once)
+    uint32_t    discontinuity_mask;     ///< Unexpected CC with discontinuity_indicator set
+
+    ContinuityResult()
+        : error_mask(0)
+        , duplicate_mask(0)
+        , discontinuity_mask(0)
+    {}
+};
+
+/**
+ * @brief Check the continuity counters of a decoded batch
+ *
+ * The previous counter of each packet is gathered from the PID state
+ * table in packet order (so a PID repeated within the batch is checked
+ * against its own earlier packet), then all packets are compared against
+ * their expected counter at once: the counter advances only on packets
+ * carrying a payload. A packet may be sent twice: the first repeat of a
+ * counter is a duplicate, a further repeat an error. The state table is
+ * left holding the last counter of every PID in the batch.
+ *
+ * @param batch Decoded headers
+ * @param packet_mask Packets to check (others are ignored and leave the state untouched)
+ * @param indicator_mask Packets with discontinuity_indicator set
+ * @param states Per-PID state (last_cc, PID_STATE_CC_VALID)
+ * @param result Receives the verdict masks
+ */
+void checkContinuity(const PacketHeaderBatch& batch, uint32_t packet_mask,
+                     uint32_t indicator_mask, PIDStateTable& states,
+                     ContinuityResult& result);
+
+/**
+ * @brief Same as checkContinuity(), using a specific kernel
+ */
+void checkContinuity(SyncScanKernel kernel, const PacketHeaderBatch& batch,
+                     uint32_t packet_mask, uint32_t indicator_mask,
+                     PIDStateTable& states, ContinuityResult& result);
+
+} // namespace mpegts
+
+#endif // MPEGTS_BATCH_HPP
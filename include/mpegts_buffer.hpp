@@ -0,0 +1,90 @@
+#ifndef MPEGTS_BUFFER_HPP
+#define MPEGTS_BUFFER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace mpegts {
+
+/**
+ * @brief Fixed-capacity ingest buffer with a consumed-offset front
+ *
+ * Consuming bytes only advances a read offset, so trimming the front
+ * never shifts data. The backing storage is twice the capacity; the
+ * unread bytes are moved back to the start only when an append would
+ * run past the end of the storage. Each byte is therefore moved at most
+ * once per capacity's worth of input, keeping the cost per fed byte
+ * constant regardless of chunk size.
+ */
+class IngestBuffer {
+public:
+    explicit IngestBuffer(size_t capacity);
+    ~IngestBuffer() = default;
+
+    /**
+     * @brief Append data at the back
+     *
+     * If the buffer would exceed its capacity, the oldest bytes are dropped.
+     *
+     * @param data Pointer to data
+     * @param length Size of data in bytes
+     */
+    void append(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Drop bytes from the front
+     * @param length Number of bytes to drop (clamped to size())
+     */
+    void consume(size_t length);
+
+    /**
+     * @brief Remove all data
+     */
+    void clear();
+
+    /**
+     * @brief Get pointer to the first unread byte
+     */
+    const uint8_t* data() const { return storage_.data() + read_pos_; }
+
+    /**
+     * @brief Get number of unread bytes
+     */
+    size_t size() const { return write_pos_ - read_pos_; }
+
+    /**
+     * @brief Check if buffer holds no unread bytes
+     */
+    bool empty() const { return write_pos_ == read_pos_; }
+
+    /**
+     * @brief Get maximum number of bytes held
+     */
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Get number of bytes that can be appended without dropping data
+     */
+    size_t available() const { return capacity_ - size(); }
+
+    /**
+     * @brief Access unread byte by index
+     */
+    uint8_t operator[](size_t index) const { return storage_[read_pos_ + index]; }
+
+private:
+    std::vector<uint8_t> storage_;
+    size_t capacity_;
+    size_t read_pos_;
+    size_t write_pos_;
+
+    /**
+     * @brief Move unread bytes to the start of storage
+     */
+    void compact();
+};
+
+} // namespace mpegts
+
+#endif // MPEGTS_BUFFER_HPP
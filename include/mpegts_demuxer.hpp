@@ -3,9 +3,15 @@
 
 #include "mpegts_types.hpp"
 #include "mpegts_storage.hpp"
+#include "mpegts_sink.hpp"
+#include "mpegts_buffer.hpp"
+#include "mpegts_source.hpp"
 #include "mpegts_packet.hpp"
+#include "mpegts_pid_state.hpp"
+#include "mpegts_batch.hpp"
 #include "mpegts_psi.hpp"
 #include "mpegts_pcr.hpp"
+#include "mpegts_policies.hpp"
 #include <vector>
 #include <memory>
 #include <optional>
@@ -14,7 +20,7 @@
 namespace mpegts {
 
 /**
- * @brief Main MPEG-TS Demuxer class
+ * @brief Policy-independent part of the demuxer
  *
  * This class implements an adaptive-restorative MPEG-TS demultiplexer
  * with the following features:
@@ -23,11 +29,16 @@ namespace mpegts {
  * - Separation of normal and private payload data
  * - Support for multiple programs and streams
  * - Profile-agnostic implementation
+ *
+ * Synchronization, PSI/PCR tracking and storage live here; the packet
+ * loop is supplied by BasicDemuxer, specialized for its policies.
  */
-class MPEGTSDemuxer {
+class DemuxerCore {
 public:
-    MPEGTSDemuxer();
-    ~MPEGTSDemuxer();
+    virtual ~DemuxerCore();
+
+    DemuxerCore(const DemuxerCore&) = delete;
+    DemuxerCore& operator=(const DemuxerCore&) = delete;
 
     // ========================================================================
     // Main API - Data Input
@@ -35,10 +46,59 @@ public:
 
     /**
      * @brief Feed data to demuxer
+     *
+     * While synchronized, whole packets are parsed directly from the
+     * caller's memory. Only a partial tail packet, or the bytes still
+     * needed for resynchronization, are copied into the internal buffer.
+     * Chunks of any size are accepted: while searching for sync the input
+     * is buffered in slices of the configured capacity, so no data is
+     * dropped to make room.
+     *
      * @param data Pointer to raw data
      * @param length Size of data in bytes
+     * @return Number of bytes consumed; the remainder (if any) must be
+     *         fed again once the demuxer has drained its buffer
+     */
+    size_t feedData(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Feed data held in a reference-counted block (zero-copy)
+     *
+     * Like feedData(), but payloads of packets parsed in place keep a
+     * reference to the block instead of being copied into the stream's
+     * arena. The block stays allocated, as a whole, until the last
+     * iteration referencing it is cleared or evicted; retention limits
+     * count referenced payload bytes only. Bytes that go through the
+     * internal buffer (partial packets, resynchronization) are copied.
+     *
+     * Suited to high-rate PIDs that are forwarded and cleared promptly;
+     * a slow PID holding one iteration pins every block it spans.
+     *
+     * @param block Reference to the block owning [data, data + length)
+     * @param data Pointer to raw data inside the block
+     * @param length Size of data in bytes
+     * @return Number of bytes consumed, as for feedData()
+     */
+    size_t feedBlock(const PayloadBlockRef& block, const uint8_t* data, size_t length);
+
+    /**
+     * @brief Feed a recording from a memory-mapped file
+     *
+     * Windows of whole packets are handed to feedData() straight from the
+     * mapping; pages behind the cursor are released as ingest proceeds.
+     *
+     * @param source Open mapped source, fed from its cursor to the end
+     * @return Number of bytes consumed
      */
-    void feedData(const uint8_t* data, size_t length);
+    size_t feedFile(MappedSource& source);
+
+    /**
+     * @brief Map and feed a whole recording
+     * @param path File path
+     * @return false if the file could not be mapped or was not fed to
+     *         the end
+     */
+    bool feedFile(const std::string& path);
 
     // ========================================================================
     // Program Information
@@ -111,15 +171,69 @@ public:
      */
     void clearAll();
 
+    /**
+     * @brief Deliver finalized iterations to a sink instead of storage
+     *
+     * While a sink is attached nothing is retained: the storage accessors
+     * only see iterations finalized before it was attached. The sink is
+     * not owned; detach it (nullptr) before destroying it if the demuxer
+     * outlives it, since the destructor finalizes pending iterations.
+     *
+     * @param sink Receiver, or nullptr to store iterations again
+     */
+    void setIterationSink(IterationSink* sink) { iteration_sink_ = sink; }
+
+    /**
+     * @brief Set global limits on stored iterations
+     *
+     * Replaces DemuxerConfig::retention. Oldest iterations are evicted
+     * as limits are exceeded; ages are measured on iteration timestamps
+     * (PTS of the PES header, else the most recent PCR).
+     */
+    void setRetentionPolicy(const RetentionPolicy& policy) { storage_.setRetentionPolicy(policy); }
+
+    /**
+     * @brief Set limits on stored iterations of one stream
+     * @param pid Stream PID
+     * @param policy Limits applied in addition to the global ones
+     */
+    void setRetentionPolicy(uint16_t pid, const RetentionPolicy& policy) {
+        storage_.setRetentionPolicy(pid, policy);
+    }
+
     // ========================================================================
     // State Information
     // ========================================================================
 
     /**
      * @brief Check if demuxer is synchronized
+     *
+     * Lock is acquired after sync_acquire_count valid packets and kept
+     * until sync_loss_count consecutive packets miss the sync byte.
+     * Single corrupted packets are skipped without dropping the lock.
      */
     bool isSynchronized() const { return is_synchronized_; }
 
+    /**
+     * @brief Get packet and synchronization counters
+     */
+    const DemuxerStats& getStats() const { return stats_; }
+
+    /**
+     * @brief Get continuity counter statistics of a PID
+     */
+    const ContinuityStats& getContinuityStats(uint16_t pid) const {
+        return continuity_stats_[pid & PID_MASK];
+    }
+
+    /**
+     * @brief Get packet framing in use
+     *
+     * With PacketFormat::AUTO the framing is detected on every sync
+     * acquisition; TS is reported until the first detection.
+     */
+    PacketFormat getPacketFormat() const { return packet_format_; }
+
     /**
      * @brief Get buffer occupancy
      * @return Number of bytes in buffer
@@ -177,22 +291,69 @@ public:
      */
     std::optional<PCR> getLastPCR(uint16_t pid) const;
 
-private:
+protected:
+    explicit DemuxerCore(const DemuxerConfig& config);
+
+    /**
+     * @brief Process whole packets at a synchronized position
+     * @return Number of bytes consumed
+     */
+    virtual size_t processPackets(const uint8_t* data, size_t length) = 0;
+
     // Internal state
     DemuxerStreamStorage    storage_;
-    std::vector<uint8_t>    raw_buffer_;
+    IterationSink*          iteration_sink_;        ///< Receives iterations instead of storage_
+    PayloadBlockRef         ingest_block_;          ///< Block being fed by feedBlock()
+    bool                    reference_payloads_;    ///< Payloads point into ingest_block_
+    IngestBuffer            raw_buffer_;
 
     bool                    is_synchronized_;
     size_t                  sync_offset_;
     uint8_t                 sync_validation_depth_;
+    uint8_t                 sync_loss_threshold_;
+    uint8_t                 prefetch_distance_;
+    TEIPolicy               tei_policy_;
+    DemuxerStats            stats_;
+
+    // Packets parsed while validating sync, reused by the first
+    // processing pass (offset relative to the sync position)
+    struct ValidatedPacket {
+        size_t      offset;
+        TSPacket    packet;
+    };
+    std::vector<ValidatedPacket> validated_packets_;
+
+    // Packet framing (stride and TS packet offset inside one unit)
+    PacketFormat            configured_format_;
+    PacketFormat            packet_format_;
+    size_t                  packet_stride_;
+    size_t                  sync_byte_offset_;
 
     bool                    programs_table_available_;
-    std::set<uint16_t>      known_program_pids_;
-
-    // Current iterations being built per PID
-    std::unordered_map<uint16_t, uint32_t>        current_iteration_ids_;
-    std::unordered_map<uint16_t, IterationData>   current_iterations_;
-    std::unordered_map<uint16_t, uint8_t>         last_cc_;
+    PIDFilter               known_program_pids_;    ///< PIDs stored in program-table mode
+
+    // Role of every PID, rebuilt when the program table, PAT or a PMT
+    // changes; the packet loop classifies packets with one lookup
+    PIDRoleTable            pid_roles_;
+    bool                    probe_pcr_;     ///< No PMT yet: ignored PIDs are checked for a PCR
+
+    // Per-PID state (CC, open iteration slot), indexed by PID
+    PIDStateTable           pid_states_;
+    std::vector<ContinuityStats> continuity_stats_;     ///< CC counters, indexed by PID
+
+    // Scratch for batch processing: decoded headers and parsed packets
+    PacketHeaderBatch       header_batch_;
+    TSPacket                batch_packets_[HEADER_BATCH_SIZE];
+
+    // Iterations being built, densely packed; PIDState::iteration_slot
+    // points into this vector
+    struct OpenIteration {
+        uint16_t        pid;
+        uint32_t        id;
+        PayloadArena*   arena;      ///< Payload bytes are copied here
+        IterationData   data;
+    };
+    std::vector<OpenIteration> open_iterations_;
 
     // PSI (Program Specific Information) support
     PSIAccumulator                                pat_accumulator_;
@@ -203,20 +364,370 @@ private:
     // PCR (Program Clock Reference) support
     PCRManager                          pcr_manager_;
     uint64_t                            total_packets_processed_;
+    bool                                has_pcr_base_;      ///< last_pcr_base_ is set?
+    uint64_t                            last_pcr_base_;     ///< Most recent PCR (90 kHz), any PID
 
     // Internal methods
     bool validatePacket(const uint8_t* data);
     bool belongsToSameIteration(const TSPacket& p1, const TSPacket& p2);
-    void addPacketToStorage(const TSPacket& packet);
+    OpenIteration& currentIteration(const TSPacket& packet, bool cc_error, bool discontinuity);
+    void appendSegment(OpenIteration& iteration, PayloadType type, const uint8_t* data,
+                       size_t length, uint32_t arrival_timestamp);
     void finalizeIteration(uint16_t pid);
     void finalizeAllIterations();
-    void handleDiscontinuity(uint16_t pid);
     bool tryFindValidIteration();
+    void setPacketFormat(PacketFormat format);
+    void rebuildPIDRoles();
+    bool validateSyncPosition(const uint8_t* buffer_data, size_t buffer_size,
+                              size_t start_pos);
     void processBuffer();
-    void processPSIPacket(const TSPacket& packet);
+    void processPATPacket(const TSPacket& packet);
+    void processPMTPacket(const TSPacket& packet);
     void processPCR(const TSPacket& packet);
+    void countContinuity(const PacketHeaderBatch& batch, const ContinuityResult& result);
 };
 
+/**
+ * @brief MPEG-TS demuxer with a packet loop specialized at compile time
+ *
+ * @tparam PacketSizePolicy Framing (AutoPacketSize, or FixedPacketSize
+ *         such as TSPacketSize, which makes stride and sync byte offset
+ *         constants)
+ * @tparam FilterPolicy PIDs parsed at all (AllPIDs, StaticPIDFilter)
+ * @tparam SinkPolicy Payload types stored (KeepAllPayloads,
+ *         KeepNormalPayload, KeepPrivatePayload)
+ *
+ * See mpegts_policies.hpp. MPEGTSDemuxer is the default instantiation.
+ */
+template <typename PacketSizePolicy, typename FilterPolicy, typename SinkPolicy>
+class BasicDemuxer : public DemuxerCore {
+public:
+    BasicDemuxer()
+        : BasicDemuxer(DemuxerConfig())
+    {}
+
+    explicit BasicDemuxer(const DemuxerConfig& config)
+        : DemuxerCore(applyPolicies(config))
+    {}
+
+protected:
+    size_t processPackets(const uint8_t* data, size_t length) override;
+
+private:
+    static DemuxerConfig applyPolicies(DemuxerConfig config) {
+        if constexpr (PacketSizePolicy::FIXED) {
+            config.packet_format = PacketSizePolicy::FORMAT;
+        }
+        return config;
+    }
+
+    size_t packetStride() const {
+        if constexpr (PacketSizePolicy::FIXED) {
+            return PacketSizePolicy::STRIDE;
+        } else {
+            return packet_stride_;
+        }
+    }
+
+    /**
+     * @brief Check the raw packet for a PCR: adaptation field present,
+     *        not empty, PCR_flag set
+     */
+    static bool carriesPCR(uint8_t adaptation_control, const uint8_t* packet_data) {
+        return (adaptation_control & 0x02) && packet_data[4] > 0 && (packet_data[5] & 0x10);
+    }
+
+    size_t syncByteOffset() const {
+        if constexpr (PacketSizePolicy::FIXED) {
+            return PacketSizePolicy::SYNC_BYTE_OFFSET;
+        } else {
+            return sync_byte_offset_;
+        }
+    }
+
+    // Packets of the current batch accepted and not stored yet
+    struct PendingPackets {
+        const TSPacket* packet[HEADER_BATCH_SIZE];
+        uint32_t        arrival_timestamp[HEADER_BATCH_SIZE];
+        uint8_t         index[HEADER_BATCH_SIZE];   ///< Position in the batch
+        uint8_t         role[HEADER_BATCH_SIZE];
+        size_t          count;
+        uint32_t        cc_mask;                    ///< Packets taking part in the CC check
+        uint32_t        indicator_mask;             ///< ... with discontinuity_indicator set
+    };
+
+    void storePending(const PacketHeaderBatch& batch, PendingPackets& pending);
+    void storePacket(const TSPacket& packet, uint32_t arrival_timestamp,
+                     bool cc_error, bool discontinuity);
+};
+
+/**
+ * @brief Default demuxer: framing from the configuration, every PID,
+ *        normal and private payload stored
+ */
+using MPEGTSDemuxer = BasicDemuxer<AutoPacketSize, AllPIDs, KeepAllPayloads>;
+
+extern template class BasicDemuxer<AutoPacketSize, AllPIDs, KeepAllPayloads>;
+
+// ============================================================================
+// BasicDemuxer Implementation
+// ============================================================================
+
+template <typename PacketSizePolicy, typename FilterPolicy, typename SinkPolicy>
+size_t BasicDemuxer<PacketSizePolicy, FilterPolicy, SinkPolicy>::processPackets(
+    const uint8_t* data, size_t length) {
+    size_t offset = 0;
+
+    // Lock state machine: a slot without the sync byte is a miss. Misses
+    // are skipped while locked; only sync_loss_threshold_ consecutive
+    // misses drop the lock
+    size_t missed_syncs = 0;
+    size_t first_miss = 0;
+    bool sync_lost = false;
+
+    // Units are stride bytes; the TS packet sits sync_byte_offset bytes in
+    // (after the M2TS timestamp, before the RS parity bytes). Both are
+    // constants under a fixed packet size policy
+    const size_t stride = packetStride();
+    const size_t sync_byte_offset = syncByteOffset();
+
+    // Packets already decoded by sync validation, in offset order
+    size_t next_validated = 0;
+
+    // Packets are handled in batches of decoded headers: the per-packet
+    // pass parses and filters, then the accepted packets are continuity
+    // checked at once and stored, at the end of the batch or before a
+    // PSI or PCR packet changes the state storage depends on
+    PacketHeaderBatch& batch = header_batch_;
+    PendingPackets pending;
+
+    while (!sync_lost && offset + stride <= length) {
+        decodeHeaders(data + offset + sync_byte_offset, (length - offset) / stride,
+                      batch, stride);
+
+        pending.count = 0;
+        pending.cc_mask = 0;
+        pending.indicator_mask = 0;
+
+        size_t i = 0;
+        while (i < batch.count) {
+            const uint32_t bit = uint32_t(1) << i;
+            const uint8_t* unit = data + offset;
+            const uint8_t* packet_data = unit + sync_byte_offset;
+
+            // Prefetch ahead: while this packet is handled, load the body
+            // of the packet prefetch_distance_ further (decoding touched
+            // only its header line) and its PID state
+            const size_t ahead = i + prefetch_distance_;
+            if (ahead < batch.count && prefetch_distance_ > 0 &&
+                pid_roles_[batch.pid[ahead]] != PID_ROLE_IGNORED) {
+                const uint8_t* ahead_data = packet_data + prefetch_distance_ * stride;
+                prefetch(ahead_data + 64);
+                prefetch(ahead_data + 128);
+                prefetch(ahead_data + MPEGTS_PACKET_SIZE - 1);
+                prefetch(&pid_states_[batch.pid[ahead]]);
+            }
+
+            // Validate sync byte
+            if (!(batch.sync_mask & bit)) {
+                if (missed_syncs == 0) {
+                    first_miss = offset;
+                }
+
+                if (++missed_syncs >= sync_loss_threshold_) {
+                    // Lost synchronization: rewind to the first missed slot
+                    // so resync rescans the skipped bytes
+                    is_synchronized_ = false;
+                    stats_.sync_losses++;
+                    sync_lost = true;
+                    break;
+                }
+
+                offset += stride;
+                i++;
+                continue;
+            }
+
+            // Sync byte found again: the missed slots were corrupted packets
+            if (missed_syncs > 0) {
+                stats_.packets_skipped += missed_syncs;
+                total_packets_processed_ += missed_syncs;
+                missed_syncs = 0;
+            }
+
+            const uint16_t pid = batch.pid[i];
+
+            // Stuffing: skip the whole run of null packets in one vectorized
+            // pass, counted for bitrate accounting. The run may leave the
+            // batch, so the rest of the batch is decoded again
+            if (pid == PID_NULL) {
+                size_t run = countNullPacketRun(packet_data, (length - offset) / stride, stride);
+                stats_.null_packets += run;
+                total_packets_processed_ += run;
+                offset += run * stride;
+                i += run;
+                if (i < batch.count) {
+                    continue;
+                }
+                break;
+            }
+
+            // Every packet on the grid counts, whether it is filtered,
+            // dropped or fails to parse: PCR positions and rate estimation
+            // are in packets of the multiplex
+            total_packets_processed_++;
+
+            // Staged parse: the PID is read from the raw header first and
+            // classified by the filter policy and one role lookup; packets
+            // nobody consumes (unsubscribed PIDs) are skipped here
+            const uint8_t role = FilterPolicy::accept(pid) ? pid_roles_[pid] : uint8_t(PID_ROLE_IGNORED);
+            if (role == PID_ROLE_IGNORED) {
+                // Until a PMT names the PCR PID any PID may carry the PCR:
+                // only packets whose raw header announces one are parsed
+                if (probe_pcr_ && FilterPolicy::accept(pid) && !(batch.tei_mask & bit) &&
+                    carriesPCR(batch.adaptation_control[i], packet_data) &&
+                    batch_packets_[i].parse(packet_data, batch.header(i))) {
+                    storePending(batch, pending);
+                    processPCR(batch_packets_[i]);
+                }
+
+                offset += stride;
+                i++;
+                continue;
+            }
+
+            // Parse packet past the decoded header, unless validation
+            // already did (validation skips off-grid candidates, so drop
+            // any behind the current unit)
+            while (next_validated < validated_packets_.size() &&
+                   validated_packets_[next_validated].offset < offset) {
+                next_validated++;
+            }
+
+            TSPacket& parsed_packet = batch_packets_[i];
+            const TSPacket* packet = &parsed_packet;
+            bool parsed;
+
+            if (next_validated < validated_packets_.size() &&
+                validated_packets_[next_validated].offset == offset) {
+                packet = &validated_packets_[next_validated++].packet;
+                parsed = true;
+            } else {
+                parsed = parsed_packet.parse(packet_data, batch.header(i));
+            }
+
+            offset += stride;
+            i++;
+
+            // Packet flagged by the demodulator: still on the packet grid
+            const bool transport_error = (batch.tei_mask & bit) != 0;
+            if (transport_error) {
+                stats_.tei_packets++;
+                if (tei_policy_ == TEIPolicy::DROP) {
+                    continue;
+                }
+            }
+
+            if (!parsed) {
+                // Corrupted packet on a valid sync byte: skip it, keep lock
+                stats_.packets_skipped++;
+                continue;
+            }
+
+            // Errored payloads must not reach the PSI, PCR and CC state
+            if (!transport_error) {
+                const auto* adapt = packet->getAdaptationField();
+                const bool has_pcr = (role & PID_ROLE_PCR) && adapt && adapt->pcr_flag;
+
+                // A new PAT or PMT changes the roles and a PCR the time
+                // stamped on new iterations: store earlier packets first
+                if ((role & (PID_ROLE_PAT | PID_ROLE_PMT)) || has_pcr) {
+                    storePending(batch, pending);
+
+                    if (role & PID_ROLE_PAT) {
+                        processPATPacket(*packet);
+                    }
+                    if (role & PID_ROLE_PMT) {
+                        processPMTPacket(*packet);
+                    }
+                    if (has_pcr) {
+                        processPCR(*packet);
+                    }
+                }
+
+                pending.cc_mask |= bit;
+                pending.indicator_mask |= (adapt && adapt->discontinuity_indicator) ? bit : 0;
+            }
+
+            const size_t k = pending.count++;
+            pending.packet[k] = packet;
+            pending.arrival_timestamp[k] = (sync_byte_offset > 0) ? readArrivalTimestamp(unit) : 0;
+            pending.index[k] = static_cast<uint8_t>(i - 1);
+            pending.role[k] = role;
+        }
+
+        storePending(batch, pending);
+    }
+
+    // Unresolved misses: keep them so the next feed can decide between
+    // skipping them and rescanning after a sync loss
+    if (missed_syncs > 0) {
+        return first_miss;
+    }
+
+    return offset;
+}
+
+template <typename PacketSizePolicy, typename FilterPolicy, typename SinkPolicy>
+void BasicDemuxer<PacketSizePolicy, FilterPolicy, SinkPolicy>::storePending(
+    const PacketHeaderBatch& batch, PendingPackets& pending) {
+    // Continuity of all pending packets in one pass
+    ContinuityResult continuity;
+    checkContinuity(batch, pending.cc_mask, pending.indicator_mask, pid_states_, continuity);
+    countContinuity(batch, continuity);
+
+    // Add payload packets to storage (accumulates in current iteration).
+    // Duplicates repeat a payload already stored and are dropped
+    for (size_t k = 0; k < pending.count; ++k) {
+        const uint32_t bit = uint32_t(1) << pending.index[k];
+        if (!(pending.role[k] & PID_ROLE_PAYLOAD) || (continuity.duplicate_mask & bit)) {
+            continue;
+        }
+
+        storePacket(*pending.packet[k], pending.arrival_timestamp[k],
+                    (continuity.error_mask & bit) != 0,
+                    (continuity.discontinuity_mask & bit) != 0);
+    }
+
+    pending.count = 0;
+    pending.cc_mask = 0;
+    pending.indicator_mask = 0;
+}
+
+template <typename PacketSizePolicy, typename FilterPolicy, typename SinkPolicy>
+void BasicDemuxer<PacketSizePolicy, FilterPolicy, SinkPolicy>::storePacket(
+    const TSPacket& packet, uint32_t arrival_timestamp, bool cc_error, bool discontinuity) {
+    // Only PIDs with PID_ROLE_PAYLOAD get here (system PIDs and PIDs
+    // outside the program table never do)
+    OpenIteration& iteration = currentIteration(packet, cc_error, discontinuity);
+
+    // Extract private data from adaptation field
+    if constexpr (SinkPolicy::KEEP_PRIVATE) {
+        if (packet.getPrivateDataLength() > 0) {
+            appendSegment(iteration, PayloadType::PAYLOAD_PRIVATE, packet.getPrivateData(),
+                          packet.getPrivateDataLength(), arrival_timestamp);
+        }
+    }
+
+    // Extract normal payload
+    if constexpr (SinkPolicy::KEEP_NORMAL) {
+        if (packet.hasPayload() && packet.getPayloadSize() > 0) {
+            appendSegment(iteration, PayloadType::PAYLOAD_NORMAL, packet.getPayload(),
+                          packet.getPayloadSize(), arrival_timestamp);
+        }
+    }
+}
+
 } // namespace mpegts
 
 #endif // MPEGTS_DEMUXER_HPP
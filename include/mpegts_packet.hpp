@@ -46,14 +46,28 @@ struct TSAdaptationField {
     bool        transport_private_data_flag;    ///< Private data present
     bool        adaptation_extension_flag;      ///< Extension present
 
-    // Optional fields
+    // Optional fields (decoded only when their flag is set)
     uint64_t    pcr_base;                       ///< Program clock reference base
     uint16_t    pcr_extension;                  ///< PCR extension
+    uint64_t    opcr_base;                      ///< Original PCR base
+    uint16_t    opcr_extension;                 ///< Original PCR extension
+    int8_t      splice_countdown;               ///< Packets until the splicing point
 
     // Private data
     uint8_t     private_data_length;            ///< Length of private data
     const uint8_t* private_data;                ///< Pointer to private data
 
+    // Adaptation field extension (decoded only when their flag is set)
+    uint8_t     extension_length;               ///< Adaptation field extension length
+    bool        ltw_flag;                       ///< Legal time window present
+    bool        piecewise_rate_flag;            ///< Piecewise rate present
+    bool        seamless_splice_flag;           ///< Seamless splice present
+    bool        ltw_valid;                      ///< ltw_offset is valid
+    uint16_t    ltw_offset;                     ///< Legal time window offset (15 bits)
+    uint32_t    piecewise_rate;                 ///< Piecewise rate (22 bits, 50 bytes/s units)
+    uint8_t     splice_type;                    ///< Splice type (4 bits)
+    uint64_t    dts_next_au;                    ///< DTS of the first AU after the splice (33 bits)
+
     TSAdaptationField()
         : length(0)
         , discontinuity_indicator(false)
@@ -66,8 +80,20 @@ struct TSAdaptationField {
         , adaptation_extension_flag(false)
         , pcr_base(0)
         , pcr_extension(0)
+        , opcr_base(0)
+        , opcr_extension(0)
+        , splice_countdown(0)
         , private_data_length(0)
         , private_data(nullptr)
+        , extension_length(0)
+        , ltw_flag(false)
+        , piecewise_rate_flag(false)
+        , seamless_splice_flag(false)
+        , ltw_valid(false)
+        , ltw_offset(0)
+        , piecewise_rate(0)
+        , splice_type(0)
+        , dts_next_au(0)
     {}
 };
 
@@ -81,11 +107,27 @@ public:
 
     /**
      * @brief Parse packet from raw data
+     *
+     * Packets with transport_error_indicator set are parsed normally;
+     * check the header flag to reject them.
+     *
      * @param data Pointer to 188-byte packet
      * @return true if packet is valid
      */
     bool parse(const uint8_t* data);
 
+    /**
+     * @brief Parse packet whose header is already decoded
+     *
+     * Only the adaptation field and payload are read from data; the
+     * header is taken as decoded (e.g. from a PacketHeaderBatch).
+     *
+     * @param data Pointer to 188-byte packet
+     * @param header Decoded header of the packet
+     * @return true if packet is valid
+     */
+    bool parse(const uint8_t* data, const TSPacketHeader& header);
+
     /**
      * @brief Validate packet structure
      * @return true if packet is valid
@@ -156,10 +198,27 @@ private:
      */
     bool parseHeader(const uint8_t* data);
 
+    /**
+     * @brief Clear adaptation field and payload left by a previous parse
+     */
+    void clearBody();
+
+    /**
+     * @brief Parse adaptation field and payload (header already set)
+     */
+    bool parseBody(const uint8_t* data);
+
     /**
      * @brief Parse adaptation field
      */
     bool parseAdaptationField(const uint8_t* data, size_t offset);
+
+    /**
+     * @brief Parse adaptation field extension
+     * @param data Pointer to adaptation_field_extension_length
+     * @param available Bytes left in the adaptation field
+     */
+    bool parseAdaptationExtension(const uint8_t* data, size_t available);
 };
 
 } // namespace mpegts
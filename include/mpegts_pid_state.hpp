@@ -0,0 +1,143 @@
+#ifndef MPEGTS_PID_STATE_HPP
+#define MPEGTS_PID_STATE_HPP
+
+#include "mpegts_types.hpp"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace mpegts {
+
+/**
+ * @brief PIDState flag bits
+ */
+enum PIDStateFlag : uint8_t {
+    PID_STATE_CC_VALID      = 0x01,     ///< last_cc holds a received counter
+    PID_STATE_ITERATION     = 0x02,     ///< An iteration is being built
+    PID_STATE_REPEATED      = 0x04      ///< Last packet repeated the counter before it
+};
+
+/**
+ * @brief Per-PID demuxer state (8 bytes, eight entries per cache line)
+ */
+struct PIDState {
+    uint32_t    iteration_slot;     ///< Index of the open iteration
+    uint8_t     last_cc;            ///< Last continuity counter
+    uint8_t     flags;              ///< PIDStateFlag bits
+    uint16_t    segment_hint;       ///< Segments in the last iteration (reserved for the next)
+};
+
+/**
+ * @brief Dense state table indexed directly by the 13-bit PID
+ *
+ * Replaces per-PID hash maps on the packet path: a lookup is one indexed
+ * load. The 64 KB table is allocated once, cache-line aligned.
+ */
+class PIDStateTable {
+public:
+    PIDStateTable()
+        : table_(new Table())
+    {
+        reset();
+    }
+
+    /**
+     * @brief Get state for a PID
+     */
+    PIDState& operator[](uint16_t pid) { return table_->entries[pid & PID_MASK]; }
+    const PIDState& operator[](uint16_t pid) const { return table_->entries[pid & PID_MASK]; }
+
+    /**
+     * @brief Reset all entries to the empty state
+     */
+    void reset() { std::memset(table_->entries, 0, sizeof(table_->entries)); }
+
+private:
+    struct alignas(64) Table {
+        PIDState entries[PID_COUNT];
+    };
+
+    std::unique_ptr<Table> table_;
+};
+
+/**
+ * @brief 8192-bit PID set
+ *
+ * Membership is a single bit test; the whole set fits in 1 KB.
+ */
+class PIDFilter {
+public:
+    PIDFilter() { clear(); }
+
+    /**
+     * @brief Add a PID to the set
+     */
+    void set(uint16_t pid) {
+        pid &= PID_MASK;
+        words_[pid >> 6] |= (uint64_t(1) << (pid & 63));
+    }
+
+    /**
+     * @brief Check if a PID is in the set
+     */
+    bool test(uint16_t pid) const {
+        pid &= PID_MASK;
+        return (words_[pid >> 6] >> (pid & 63)) & 1;
+    }
+
+    /**
+     * @brief Remove all PIDs
+     */
+    void clear() { std::memset(words_, 0, sizeof(words_)); }
+
+private:
+    uint64_t words_[PID_COUNT / 64];
+};
+
+/**
+ * @brief What the demuxer does with packets of a PID (bit flags)
+ */
+enum PIDRole : uint8_t {
+    PID_ROLE_IGNORED        = 0x00,     ///< Not parsed
+    PID_ROLE_PAT            = 0x01,     ///< Program association sections
+    PID_ROLE_PMT            = 0x02,     ///< Program map sections
+    PID_ROLE_PCR            = 0x04,     ///< PCR carrier
+    PID_ROLE_PAYLOAD        = 0x08      ///< Payload stored in iterations
+};
+
+/**
+ * @brief Dense PIDRole table indexed directly by the 13-bit PID
+ *
+ * Classifying a packet is one byte load; the 8 KB table stays in L1.
+ */
+class PIDRoleTable {
+public:
+    PIDRoleTable() { fill(PID_ROLE_IGNORED); }
+
+    /**
+     * @brief Get roles of a PID
+     */
+    uint8_t operator[](uint16_t pid) const { return roles_[pid & PID_MASK]; }
+
+    /**
+     * @brief Add roles to a PID
+     */
+    void add(uint16_t pid, uint8_t roles) { roles_[pid & PID_MASK] |= roles; }
+
+    /**
+     * @brief Replace the roles of a PID
+     */
+    void set(uint16_t pid, uint8_t roles) { roles_[pid & PID_MASK] = roles; }
+
+    /**
+     * @brief Give all PIDs the same roles
+     */
+    void fill(uint8_t roles) { std::memset(roles_, roles, sizeof(roles_)); }
+
+private:
+    alignas(64) uint8_t roles_[PID_COUNT];
+};
+
+} // namespace mpegts
+
+#endif // MPEGTS_PID_STATE_HPP
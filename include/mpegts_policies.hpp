@@ -0,0 +1,102 @@
+#ifndef MPEGTS_POLICIES_HPP
+#define MPEGTS_POLICIES_HPP
+
+#include "mpegts_types.hpp"
+#include <cstdint>
+#include <cstddef>
+
+namespace mpegts {
+
+// ============================================================================
+// Packet Size Policies
+//
+// Framing of the input. A fixed size turns the packet stride and the sync
+// byte offset into constants of the packet loop.
+// ============================================================================
+
+/**
+ * @brief Framing taken from DemuxerConfig::packet_format (AUTO detects it)
+ */
+struct AutoPacketSize {
+    static constexpr bool           FIXED = false;
+    static constexpr PacketFormat   FORMAT = PacketFormat::AUTO;
+};
+
+/**
+ * @brief Framing fixed at compile time (DemuxerConfig::packet_format is ignored)
+ */
+template <PacketFormat Format>
+struct FixedPacketSize {
+    static_assert(Format != PacketFormat::AUTO, "Use AutoPacketSize for detection");
+
+    static constexpr bool           FIXED = true;
+    static constexpr PacketFormat   FORMAT = Format;
+    static constexpr size_t         STRIDE = getPacketStride(Format);
+    static constexpr size_t         SYNC_BYTE_OFFSET = getSyncByteOffset(Format);
+};
+
+using TSPacketSize = FixedPacketSize<PacketFormat::TS>;         ///< 188-byte packets
+using M2TSPacketSize = FixedPacketSize<PacketFormat::M2TS>;     ///< 192-byte M2TS units
+using RSPacketSize = FixedPacketSize<PacketFormat::TS_RS>;      ///< 204-byte packets with parity
+
+// ============================================================================
+// Filter Policies
+//
+// accept(pid) is checked on the raw header before anything else; packets
+// it rejects are never parsed. The runtime program table still applies to
+// the PIDs it accepts.
+// ============================================================================
+
+/**
+ * @brief Accept every PID
+ */
+struct AllPIDs {
+    static constexpr bool accept(uint16_t) { return true; }
+};
+
+/**
+ * @brief Accept only the listed PIDs
+ *
+ * List the PAT/PMT and PCR PIDs as well if PSI and PCR tracking are
+ * wanted; the check compiles to a few compares against constants.
+ */
+template <uint16_t... Pids>
+struct StaticPIDFilter {
+    static_assert(sizeof...(Pids) > 0, "StaticPIDFilter needs at least one PID");
+
+    static constexpr bool accept(uint16_t pid) { return ((pid == Pids) || ...); }
+};
+
+// ============================================================================
+// Sink Policies
+//
+// Which payload types are stored in iterations.
+// ============================================================================
+
+/**
+ * @brief Store normal payload and adaptation field private data
+ */
+struct KeepAllPayloads {
+    static constexpr bool KEEP_NORMAL = true;
+    static constexpr bool KEEP_PRIVATE = true;
+};
+
+/**
+ * @brief Store normal payload only; private data is not copied
+ */
+struct KeepNormalPayload {
+    static constexpr bool KEEP_NORMAL = true;
+    static constexpr bool KEEP_PRIVATE = false;
+};
+
+/**
+ * @brief Store adaptation field private data only
+ */
+struct KeepPrivatePayload {
+    static constexpr bool KEEP_NORMAL = false;
+    static constexpr bool KEEP_PRIVATE = true;
+};
+
+} // namespace mpegts
+
+#endif // MPEGTS_POLICIES_HPP
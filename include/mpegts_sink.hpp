@@ -0,0 +1,104 @@
+#ifndef MPEGTS_SINK_HPP
+#define MPEGTS_SINK_HPP
+
+#include "mpegts_types.hpp"
+#include <cstdint>
+#include <cstddef>
+
+namespace mpegts {
+
+/**
+ * @brief Read-only view of a finalized iteration
+ *
+ * Refers to the demuxer's own buffers: the view and every pointer
+ * obtained from it are valid only until onIterationComplete() returns.
+ */
+class IterationView {
+public:
+    IterationView(uint32_t iteration_id, const IterationData& data)
+        : iteration_id_(iteration_id)
+        , data_(data)
+    {}
+
+    /**
+     * @brief Get iteration ID
+     */
+    uint32_t getIterationID() const { return iteration_id_; }
+
+    /**
+     * @brief Get underlying iteration data (flags, CC range, packet count)
+     */
+    const IterationData& getData() const { return data_; }
+
+    /**
+     * @brief Get number of payload segments
+     */
+    size_t getSegmentCount() const { return data_.payloads.size(); }
+
+    /**
+     * @brief Get payload segment by index, in arrival order
+     */
+    PayloadBuffer getSegment(size_t index) const {
+        const PayloadSegment& segment = data_.payloads[index];
+
+        PayloadBuffer buffer;
+        buffer.data = segment.data;
+        buffer.length = segment.length;
+        buffer.type = segment.type;
+        buffer.arrival_timestamp = segment.arrival_timestamp;
+        return buffer;
+    }
+
+    /**
+     * @brief Get summary (same as a getIterationsSummary() entry)
+     */
+    IterationInfo getInfo() const {
+        IterationInfo info;
+        info.iteration_id = iteration_id_;
+        info.has_discontinuity = data_.discontinuity_detected;
+        info.has_cc_error = data_.cc_error_detected;
+        info.has_transport_error = data_.transport_error_detected;
+        info.cc_start = data_.first_cc;
+        info.cc_end = data_.last_cc;
+        info.packet_count = data_.packet_count;
+
+        for (const auto& payload : data_.payloads) {
+            if (payload.type == PayloadType::PAYLOAD_NORMAL) {
+                info.payload_normal_size += payload.length;
+            } else {
+                info.payload_private_size += payload.length;
+            }
+        }
+        return info;
+    }
+
+private:
+    uint32_t                iteration_id_;
+    const IterationData&    data_;
+};
+
+/**
+ * @brief Receiver of finalized iterations (push-style delivery)
+ *
+ * While a sink is attached to the demuxer, finalized iterations are
+ * handed to it and not retained in storage, so memory stays bounded by
+ * the number of PIDs with an open iteration. Callbacks run on the thread
+ * that feeds the demuxer, from feedData() and from calls that finalize
+ * pending iterations, such as getPrograms(), clearAll() and the
+ * destructor.
+ */
+class IterationSink {
+public:
+    virtual ~IterationSink() = default;
+
+    /**
+     * @brief Called once for every finalized iteration
+     * @param pid Stream PID
+     * @param iteration View valid only for the duration of the call
+     */
+    virtual void onIterationComplete(uint16_t pid, const IterationView& iteration) = 0;
+};
+
+} // namespace mpegts
+
+#endif // MPEGTS_SINK_HPP
@@ -0,0 +1,104 @@
+#ifndef MPEGTS_SOURCE_HPP
+#define MPEGTS_SOURCE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace mpegts {
+
+/**
+ * @brief Read-only memory-mapped file for sequential ingest
+ *
+ * The file is mapped once and read front to back through a cursor.
+ * Windows handed out by nextWindow() point straight into the mapping, so
+ * they can be fed to the demuxer without copying. The kernel is advised
+ * of sequential access (read-ahead), and pages behind the cursor are
+ * released as it advances, so resident memory stays bounded on
+ * multi-gigabyte recordings.
+ */
+class MappedSource {
+public:
+    MappedSource();
+    ~MappedSource();
+
+    MappedSource(const MappedSource&) = delete;
+    MappedSource& operator=(const MappedSource&) = delete;
+
+    /**
+     * @brief Map a file (closes any previously mapped file)
+     * @param path File path
+     * @return true if the file was mapped (an empty file maps to no data)
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmap the file and reset the cursor
+     */
+    void close();
+
+    /**
+     * @brief Check if a file is mapped
+     */
+    bool isOpen() const { return is_open_; }
+
+    /**
+     * @brief Get pointer to the whole mapping
+     */
+    const uint8_t* data() const { return data_; }
+
+    /**
+     * @brief Get file size in bytes
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Get cursor position
+     */
+    size_t position() const { return position_; }
+
+    /**
+     * @brief Check if the cursor reached the end of the file
+     */
+    bool atEnd() const { return position_ >= size_; }
+
+    /**
+     * @brief Get the next window at the cursor without advancing it
+     *
+     * The window length is a multiple of alignment, unless it covers the
+     * rest of the file.
+     *
+     * @param window Receives pointer to the window
+     * @param max_bytes Upper bound on the window length
+     * @param alignment Unit the window length is rounded down to
+     * @return Window length in bytes (0 at end of file)
+     */
+    size_t nextWindow(const uint8_t*& window, size_t max_bytes, size_t alignment) const;
+
+    /**
+     * @brief Move the cursor forward and release pages behind it
+     * @param bytes Number of bytes consumed (clamped to the file end)
+     */
+    void advance(size_t bytes);
+
+private:
+    const uint8_t*  data_;
+    size_t          size_;
+    size_t          position_;
+    size_t          released_;      ///< Bytes at the front already returned to the OS
+    bool            is_open_;
+
+#ifdef _WIN32
+    void*           file_handle_;
+    void*           mapping_handle_;
+#endif
+
+    /**
+     * @brief Release whole pages before the cursor
+     */
+    void releaseConsumed();
+};
+
+} // namespace mpegts
+
+#endif // MPEGTS_SOURCE_HPP
@@ -2,18 +2,40 @@
 #define MPEGTS_STORAGE_HPP
 
 #include "mpegts_types.hpp"
+#include <deque>
 #include <map>
 #include <vector>
 #include <memory>
 
 namespace mpegts {
 
+/**
+ * @brief Iteration and payload byte totals shared by a storage's streams
+ */
+struct StorageUsage {
+    size_t  iterations;     ///< Iterations held
+    size_t  bytes;          ///< Payload bytes held
+
+    StorageUsage()
+        : iterations(0)
+        , bytes(0)
+    {}
+};
+
 /**
  * @brief Container for iterations of a single stream (PID)
+ *
+ * Iterations are kept in arrival order, so the oldest one is always at
+ * the front and evicting it is O(1).
  */
 class StreamIterations {
 public:
-    StreamIterations(uint16_t pid);
+    /**
+     * @param pid Stream PID
+     * @param usage Totals updated as iterations are added and removed
+     *        (optional, must outlive the stream)
+     */
+    StreamIterations(uint16_t pid, StorageUsage* usage = nullptr);
     ~StreamIterations() = default;
 
     /**
@@ -23,8 +45,11 @@ public:
 
     /**
      * @brief Add new iteration
+     *
+     * The data is moved in; segment pointers refer to arena pages and
+     * stay valid as they are.
      */
-    void addIteration(uint32_t iter_id, const IterationData& data);
+    void addIteration(uint32_t iter_id, IterationData&& data);
 
     /**
      * @brief Get iteration by ID
@@ -32,9 +57,9 @@ public:
     const IterationData* getIteration(uint32_t iter_id) const;
 
     /**
-     * @brief Get all iterations
+     * @brief Get all iterations, oldest first
      */
-    const std::vector<std::pair<uint32_t, IterationData>>& getIterations() const {
+    const std::deque<std::pair<uint32_t, IterationData>>& getIterations() const {
         return iterations_;
     }
 
@@ -43,6 +68,40 @@ public:
      */
     void removeIteration(uint32_t iter_id);
 
+    /**
+     * @brief Remove the oldest iteration
+     * @return false if the stream is empty
+     */
+    bool evictOldest();
+
+    /**
+     * @brief Evict oldest iterations until the stream is within limits
+     *
+     * Age is measured from the highest timestamp seen, so out-of-order
+     * PTS do not evict anything; a step back of more than 10 s is taken
+     * as a clock jump. Iterations without a timestamp take the one of
+     * the iteration before them, so the age span covers the whole stream.
+     *
+     * @return Number of iterations evicted
+     */
+    size_t enforceRetention(const RetentionPolicy& policy);
+
+    /**
+     * @brief Set limits of this stream, applied as iterations are added
+     *        through DemuxerStreamStorage
+     */
+    void setRetentionPolicy(const RetentionPolicy& policy) { policy_ = policy; }
+
+    /**
+     * @brief Get limits of this stream
+     */
+    const RetentionPolicy& getRetentionPolicy() const { return policy_; }
+
+    /**
+     * @brief Get payload bytes held by this stream
+     */
+    size_t getPayloadBytes() const { return payload_bytes_; }
+
     /**
      * @brief Clear all iterations
      */
@@ -60,8 +119,17 @@ public:
 
 private:
     uint16_t pid_;
-    std::vector<std::pair<uint32_t, IterationData>> iterations_;
+    std::deque<std::pair<uint32_t, IterationData>> iterations_;
     std::set<uint8_t> observed_cc_values_;
+
+    RetentionPolicy policy_;
+    StorageUsage*   usage_;
+    size_t          payload_bytes_;
+    bool            has_timestamp_;     ///< Timestamps below are set?
+    uint64_t        last_timestamp_;    ///< Timestamp of the last iteration added
+    uint64_t        newest_timestamp_;  ///< Highest timestamp seen (age reference)
+
+    void release(const IterationData& data);
 };
 
 /**
@@ -72,6 +140,10 @@ public:
     DemuxerStreamStorage();
     ~DemuxerStreamStorage() = default;
 
+    // Streams point at usage_
+    DemuxerStreamStorage(const DemuxerStreamStorage&) = delete;
+    DemuxerStreamStorage& operator=(const DemuxerStreamStorage&) = delete;
+
     /**
      * @brief Get or create stream for PID
      */
@@ -82,6 +154,51 @@ public:
      */
     const StreamIterations* getStream(uint16_t pid) const;
 
+    /**
+     * @brief Get payload arena of a stream
+     *
+     * Arenas exist independently of streams (iterations delivered to a
+     * sink are never stored) and are released by clear().
+     */
+    PayloadArena& getArena(uint16_t pid);
+
+    /**
+     * @brief Set page size of arenas created from now on
+     */
+    void setArenaPageSize(size_t page_size) { arena_page_size_ = page_size; }
+
+    /**
+     * @brief Add iteration to a stream and apply retention limits
+     *
+     * The stream's own policy is applied first, then the global one.
+     */
+    void addIteration(uint16_t pid, uint32_t iter_id, IterationData&& data);
+
+    /**
+     * @brief Set global limits
+     *
+     * max_bytes and max_iterations cap the totals over all streams; the
+     * oldest iterations of the whole storage are evicted first. max_age
+     * applies to each stream separately, as streams may follow different
+     * program clocks.
+     */
+    void setRetentionPolicy(const RetentionPolicy& policy);
+
+    /**
+     * @brief Set limits of one stream (in addition to the global ones)
+     */
+    void setRetentionPolicy(uint16_t pid, const RetentionPolicy& policy);
+
+    /**
+     * @brief Get global limits
+     */
+    const RetentionPolicy& getRetentionPolicy() const { return policy_; }
+
+    /**
+     * @brief Get totals over all streams
+     */
+    const StorageUsage& getUsage() const { return usage_; }
+
     /**
      * @brief Get all streams
      */
@@ -115,8 +232,23 @@ public:
     bool hasStream(uint16_t pid) const;
 
 private:
+    // Arenas are declared first so stored iterations release their pages
+    // before the arenas go
+    std::map<uint16_t, std::unique_ptr<PayloadArena>> arenas_;
+    size_t arena_page_size_;
+
     std::map<uint16_t, StreamIterations> streams_;
     uint32_t next_iteration_id_;
+
+    RetentionPolicy policy_;
+    StorageUsage    usage_;
+    std::map<uint16_t, RetentionPolicy> stream_policies_;
+
+    // Stored iterations in arrival order, for global eviction. Entries of
+    // iterations removed otherwise are skipped when they reach the front
+    std::deque<std::pair<uint16_t, uint32_t>> arrival_order_;
+
+    void enforceGlobalRetention();
 };
 
 } // namespace mpegts
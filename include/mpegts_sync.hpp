@@ -0,0 +1,105 @@
+#ifndef MPEGTS_SYNC_HPP
+#define MPEGTS_SYNC_HPP
+
+#include "mpegts_types.hpp"
+#include <cstdint>
+#include <cstddef>
+
+namespace mpegts {
+
+// ============================================================================
+// Sync Byte Scanner
+// ============================================================================
+
+/**
+ * @brief Implementation used to scan for sync candidates
+ */
+enum class SyncScanKernel : uint8_t {
+    SCALAR  = 0,    ///< Portable byte-by-byte scan
+    SSE2    = 1,    ///< 16 positions per step
+    AVX2    = 2,    ///< 32 positions per step
+    AVX512  = 3     ///< 64 positions per step (AVX-512BW)
+};
+
+/**
+ * @brief Get the fastest kernel supported by this CPU
+ *
+ * Detected once via cpuid and cached.
+ */
+SyncScanKernel detectSyncScanKernel();
+
+/**
+ * @brief Check if kernel can run on this CPU
+ */
+bool isSyncScanKernelSupported(SyncScanKernel kernel);
+
+/**
+ * @brief Get string name for kernel
+ */
+const char* getSyncScanKernelName(SyncScanKernel kernel);
+
+/**
+ * @brief Find first position where the sync byte repeats one and two
+ *        strides later
+ *
+ * Only positions p with p + 2 * stride < length are considered, so all
+ * three bytes lie inside the data.
+ *
+ * @param data Pointer to data
+ * @param length Data length
+ * @param stride Distance between sync bytes (packet size)
+ * @return Offset of first candidate, or length if none found
+ */
+size_t findSyncCandidate(const uint8_t* data, size_t length,
+                         size_t stride = MPEGTS_PACKET_SIZE);
+
+/**
+ * @brief Same as findSyncCandidate(), using a specific kernel
+ *
+ * The kernel must be supported by the CPU.
+ */
+size_t findSyncCandidate(SyncScanKernel kernel, const uint8_t* data,
+                         size_t length, size_t stride = MPEGTS_PACKET_SIZE);
+
+// ============================================================================
+// Null Packet Pre-pass
+// ============================================================================
+
+/**
+ * @brief Count consecutive null packets (sync byte and PID 0x1FFF)
+ *
+ * The header bytes of a batch of packets are gathered into one vector
+ * and tested at once, so runs of stuffing can be skipped in bulk.
+ *
+ * @param data Pointer to the sync byte of the first packet
+ * @param count Number of packets available (at data + i * stride)
+ * @param stride Distance between packets
+ * @return Number of null packets before the first other packet
+ */
+size_t countNullPacketRun(const uint8_t* data, size_t count,
+                          size_t stride = MPEGTS_PACKET_SIZE);
+
+/**
+ * @brief Same as countNullPacketRun(), using a specific kernel
+ *
+ * The kernel must be supported by the CPU.
+ */
+size_t countNullPacketRun(SyncScanKernel kernel, const uint8_t* data,
+                          size_t count, size_t stride = MPEGTS_PACKET_SIZE);
+
+/**
+ * @brief Detect packet framing by scoring sync byte periodicity
+ *
+ * For each of the 188, 192 and 204-byte strides, the first periodic
+ * candidate is located and the sync bytes on its grid are counted. The
+ * stride with the highest count wins; ties prefer the smaller stride.
+ *
+ * @param data Pointer to data
+ * @param length Data length
+ * @return Detected format, or AUTO if no stride shows a periodic sync byte
+ */
+PacketFormat detectPacketFormat(const uint8_t* data, size_t length);
+
+} // namespace mpegts
+
+#endif // MPEGTS_SYNC_HPP
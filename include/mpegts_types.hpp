@@ -1,11 +1,17 @@
 #ifndef MPEGTS_TYPES_HPP
 #define MPEGTS_TYPES_HPP
 
+#include "mpegts_arena.hpp"
 #include <cstdint>
+#include <cstddef>
 #include <vector>
 #include <map>
 #include <set>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
 namespace mpegts {
 
 // ============================================================================
@@ -13,8 +19,11 @@ namespace mpegts {
 // ============================================================================
 
 constexpr size_t MPEGTS_PACKET_SIZE = 188;      // Standard MPEG-TS packet size
+constexpr size_t M2TS_PACKET_SIZE = 192;        // BDAV packet (4-byte timestamp + TS packet)
+constexpr size_t RS_PACKET_SIZE = 204;          // TS packet + 16 Reed-Solomon parity bytes
+constexpr size_t M2TS_HEADER_SIZE = 4;          // BDAV TP_extra_header size
 constexpr uint8_t MPEGTS_SYNC_BYTE = 0x47;      // Sync byte
-constexpr size_t MAX_BUFFER_PACKETS = 100;      // Maximum packets in buffer
+constexpr size_t MAX_BUFFER_PACKETS = 100;      // Default packets in buffer
 constexpr size_t MAX_BUFFER_SIZE = MPEGTS_PACKET_SIZE * MAX_BUFFER_PACKETS;
 
 // System PIDs
@@ -22,6 +31,8 @@ constexpr uint16_t PID_PAT = 0x0000;
 constexpr uint16_t PID_CAT = 0x0001;
 constexpr uint16_t PID_TSDT = 0x0002;
 constexpr uint16_t PID_NULL = 0x1FFF;
+constexpr uint16_t PID_MASK = 0x1FFF;           // 13-bit PID field
+constexpr size_t PID_COUNT = 8192;              // Number of distinct PIDs
 
 // ============================================================================
 // Enumerations
@@ -45,6 +56,24 @@ enum class AdaptationFieldControl : uint8_t {
     ADAPTATION_PAYLOAD  = 0x03      ///< Both adaptation field and payload
 };
 
+/**
+ * @brief Packet framing of the input stream
+ */
+enum class PacketFormat : uint8_t {
+    AUTO    = 0,    ///< Detect from sync byte periodicity
+    TS      = 1,    ///< 188-byte transport stream packets
+    M2TS    = 2,    ///< 192-byte BDAV packets with arrival timestamp prefix
+    TS_RS   = 3     ///< 204-byte packets with Reed-Solomon parity suffix
+};
+
+/**
+ * @brief Handling of packets with transport_error_indicator set
+ */
+enum class TEIPolicy : uint8_t {
+    DROP            = 0,    ///< Count and discard the packet
+    PASS_FLAGGED    = 1     ///< Count and store the packet, flagging its iteration
+};
+
 // ============================================================================
 // Structures
 // ============================================================================
@@ -56,13 +85,16 @@ struct PayloadSegment {
     PayloadType     type;               ///< Type of payload
     const uint8_t*  data;               ///< Pointer to data
     size_t          length;             ///< Size in bytes
-    size_t          offset_in_stream;   ///< Position in the overall stream
+    size_t          offset_in_stream;   ///< Position in the iteration's payload
+    uint32_t        arrival_timestamp;  ///< M2TS arrival time stamp of the packet (0 otherwise)
+    PayloadBlockRef block;              ///< Keeps the memory behind data alive (empty if not owned)
 
     PayloadSegment()
         : type(PayloadType::PAYLOAD_NORMAL)
         , data(nullptr)
         , length(0)
         , offset_in_stream(0)
+        , arrival_timestamp(0)
     {}
 };
 
@@ -70,11 +102,13 @@ struct PayloadSegment {
  * @brief Data for one iteration (group of related packets)
  */
 struct IterationData {
-    std::vector<PayloadSegment> payloads;           ///< Payload segments
-    std::vector<uint8_t>        payload_data;       ///< Actual payload data storage
+    std::vector<PayloadSegment> payloads;           ///< Payload segments (bytes in a PayloadArena)
+    size_t                      payload_size;       ///< Total bytes of all segments
 
     // Flags
-    bool    discontinuity_detected;                 ///< CC discontinuity detected?
+    bool    discontinuity_detected;                 ///< Signalled CC discontinuity detected?
+    bool    cc_error_detected;                      ///< Unsignalled CC jump (packet loss) detected?
+    bool    transport_error_detected;               ///< Packet with TEI set stored?
     bool    payload_unit_start_seen;                ///< PES frame start seen?
     bool    is_complete;                            ///< Frame complete?
 
@@ -83,15 +117,22 @@ struct IterationData {
     uint8_t last_cc;                                ///< Last continuity counter
     size_t  packet_count;                           ///< Number of packets
     size_t  buffer_position;                        ///< Position in buffer
+    bool    has_timestamp;                          ///< timestamp is set?
+    uint64_t timestamp;                             ///< Start time (90 kHz, PTS or last PCR)
 
     IterationData()
-        : discontinuity_detected(false)
+        : payload_size(0)
+        , discontinuity_detected(false)
+        , cc_error_detected(false)
+        , transport_error_detected(false)
         , payload_unit_start_seen(false)
         , is_complete(false)
         , first_cc(0)
         , last_cc(0)
         , packet_count(0)
         , buffer_position(0)
+        , has_timestamp(false)
+        , timestamp(0)
     {}
 };
 
@@ -99,14 +140,16 @@ struct IterationData {
  * @brief Payload buffer returned by API
  */
 struct PayloadBuffer {
-    const uint8_t*  data;       ///< Pointer to data
-    size_t          length;     ///< Size in bytes
-    PayloadType     type;       ///< Type of payload
+    const uint8_t*  data;               ///< Pointer to data
+    size_t          length;             ///< Size in bytes
+    PayloadType     type;               ///< Type of payload
+    uint32_t        arrival_timestamp;  ///< M2TS arrival time stamp of the packet (0 otherwise)
 
     PayloadBuffer()
         : data(nullptr)
         , length(0)
         , type(PayloadType::PAYLOAD_NORMAL)
+        , arrival_timestamp(0)
     {}
 };
 
@@ -118,6 +161,8 @@ struct IterationInfo {
     size_t      payload_normal_size;    ///< Size of normal payload
     size_t      payload_private_size;   ///< Size of private payload
     bool        has_discontinuity;      ///< Discontinuity flag
+    bool        has_cc_error;           ///< Continuity counter error (lost packets)
+    bool        has_transport_error;    ///< Contains packets with TEI set
     uint8_t     cc_start;               ///< Starting CC
     uint8_t     cc_end;                 ///< Ending CC
     size_t      packet_count;           ///< Number of packets
@@ -127,6 +172,8 @@ struct IterationInfo {
         , payload_normal_size(0)
         , payload_private_size(0)
         , has_discontinuity(false)
+        , has_cc_error(false)
+        , has_transport_error(false)
         , cc_start(0)
         , cc_end(0)
         , packet_count(0)
@@ -159,6 +206,87 @@ struct ProgramTable {
     std::map<uint16_t, std::vector<uint16_t>> programs;
 };
 
+/**
+ * @brief Limits on iterations kept in storage (0 = unlimited)
+ *
+ * When a limit is exceeded the oldest iterations are evicted.
+ */
+struct RetentionPolicy {
+    size_t      max_bytes;          ///< Payload bytes
+    size_t      max_iterations;     ///< Number of iterations
+    uint64_t    max_age;            ///< Span from oldest to newest iteration (90 kHz ticks)
+
+    RetentionPolicy()
+        : max_bytes(0)
+        , max_iterations(0)
+        , max_age(0)
+    {}
+};
+
+/**
+ * @brief Demuxer configuration
+ */
+struct DemuxerConfig {
+    uint8_t sync_acquire_count;     ///< Valid packets required to acquire lock (N)
+    uint8_t sync_loss_count;        ///< Consecutive sync byte misses before lock is lost (M)
+    TEIPolicy tei_policy;           ///< Handling of transport_error_indicator packets
+    PacketFormat packet_format;     ///< Input framing (AUTO detects 188/192/204)
+    size_t buffer_capacity;         ///< Ingest buffer size in bytes (raised to a safe minimum)
+    uint8_t prefetch_distance;      ///< Packets prefetched ahead of the one being handled (0 = off)
+    RetentionPolicy retention;      ///< Global limits on stored iterations (default: unlimited)
+    size_t arena_page_size;         ///< Payload arena page size in bytes
+
+    DemuxerConfig()
+        : sync_acquire_count(3)
+        , sync_loss_count(3)
+        , tei_policy(TEIPolicy::DROP)
+        , packet_format(PacketFormat::AUTO)
+        , buffer_capacity(MAX_BUFFER_SIZE)
+        , prefetch_distance(4)
+        , arena_page_size(PayloadArena::DEFAULT_PAGE_SIZE)
+    {}
+};
+
+/**
+ * @brief Demuxer packet and synchronization counters
+ */
+struct DemuxerStats {
+    uint64_t    sync_acquisitions;  ///< Times lock was acquired
+    uint64_t    sync_losses;        ///< Times lock was lost
+    uint64_t    packets_skipped;    ///< Corrupted packets skipped while locked
+    uint64_t    tei_packets;        ///< Packets with transport_error_indicator set
+    uint64_t    null_packets;       ///< Null (stuffing) packets skipped
+    uint64_t    cc_errors;          ///< Unsignalled continuity counter jumps
+    uint64_t    cc_duplicates;      ///< Duplicate packets (repeated CC) dropped
+    uint64_t    cc_discontinuities; ///< Counter jumps signalled by discontinuity_indicator
+
+    DemuxerStats()
+        : sync_acquisitions(0)
+        , sync_losses(0)
+        , packets_skipped(0)
+        , tei_packets(0)
+        , null_packets(0)
+        , cc_errors(0)
+        , cc_duplicates(0)
+        , cc_discontinuities(0)
+    {}
+};
+
+/**
+ * @brief Continuity counter statistics of one PID
+ */
+struct ContinuityStats {
+    uint32_t    cc_errors;          ///< Unsignalled continuity counter jumps
+    uint32_t    duplicates;         ///< Duplicate packets (repeated CC)
+    uint32_t    discontinuities;    ///< Counter jumps signalled by discontinuity_indicator
+
+    ContinuityStats()
+        : cc_errors(0)
+        , duplicates(0)
+        , discontinuities(0)
+    {}
+};
+
 // ============================================================================
 // Helper Functions
 // ============================================================================
@@ -170,6 +298,13 @@ inline bool isSystemPID(uint16_t pid) {
     return pid == PID_PAT || pid == PID_CAT || pid == PID_TSDT || pid == PID_NULL;
 }
 
+/**
+ * @brief Read the PID from a raw packet header
+ */
+inline uint16_t readPID(const uint8_t* packet) {
+    return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+}
+
 /**
  * @brief Check if PID is a program stream
  */
@@ -177,6 +312,76 @@ inline bool isProgramStream(uint16_t pid) {
     return !isSystemPID(pid);
 }
 
+/**
+ * @brief Get size of one input unit for a packet format
+ */
+constexpr size_t getPacketStride(PacketFormat format) {
+    switch (format) {
+        case PacketFormat::M2TS: return M2TS_PACKET_SIZE;
+        case PacketFormat::TS_RS: return RS_PACKET_SIZE;
+        default: return MPEGTS_PACKET_SIZE;
+    }
+}
+
+/**
+ * @brief Get offset of the TS packet (sync byte) inside one input unit
+ */
+constexpr size_t getSyncByteOffset(PacketFormat format) {
+    return (format == PacketFormat::M2TS) ? M2TS_HEADER_SIZE : 0;
+}
+
+/**
+ * @brief Read 30-bit arrival time stamp (27 MHz) from an M2TS TP_extra_header
+ */
+inline uint32_t readArrivalTimestamp(const uint8_t* unit) {
+    return ((static_cast<uint32_t>(unit[0]) << 24) |
+            (static_cast<uint32_t>(unit[1]) << 16) |
+            (static_cast<uint32_t>(unit[2]) << 8) |
+            static_cast<uint32_t>(unit[3])) & 0x3FFFFFFF;
+}
+
+/**
+ * @brief Hint the CPU to load the cache line holding address (no-op where unsupported)
+ */
+inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+/**
+ * @brief Read a 48-bit clock reference field (PCR/OPCR)
+ *
+ * Layout: base[32:0] (90 kHz) | reserved (6 bits) | extension[8:0] (27 MHz)
+ */
+inline void readClockReference(const uint8_t* field, uint64_t& base, uint16_t& extension) {
+    const uint64_t bits = (static_cast<uint64_t>(field[0]) << 40) |
+                          (static_cast<uint64_t>(field[1]) << 32) |
+                          (static_cast<uint64_t>(field[2]) << 24) |
+                          (static_cast<uint64_t>(field[3]) << 16) |
+                          (static_cast<uint64_t>(field[4]) << 8) |
+                          static_cast<uint64_t>(field[5]);
+    base = bits >> 15;
+    extension = static_cast<uint16_t>(bits & 0x1FF);
+}
+
+/**
+ * @brief Read a 33-bit timestamp coded with marker bits (PTS/DTS, DTS_next_AU)
+ *
+ * Layout: prefix (4 bits) | ts[32:30] | marker | ts[29:15] | marker | ts[14:0] | marker
+ */
+inline uint64_t readTimestamp(const uint8_t* field) {
+    return ((static_cast<uint64_t>(field[0] & 0x0E)) << 29) |
+           (static_cast<uint64_t>(field[1]) << 22) |
+           ((static_cast<uint64_t>(field[2] & 0xFE)) << 14) |
+           (static_cast<uint64_t>(field[3]) << 7) |
+           (static_cast<uint64_t>(field[4]) >> 1);
+}
+
 } // namespace mpegts
 
 #endif // MPEGTS_TYPES_HPP
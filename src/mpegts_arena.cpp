@@ -0,0 +1,128 @@
+#include "mpegts_arena.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace mpegts {
+
+// ============================================================================
+// Pages and Pool
+// ============================================================================
+
+struct PayloadArena::Pool {
+    size_t              page_size;
+    size_t              max_free_pages;
+    size_t              page_allocations;
+    bool                open;               ///< Arena still exists
+    std::vector<Page*>  free_pages;
+};
+
+class PayloadArena::Page : public PayloadBlock {
+public:
+    Page(std::shared_ptr<Pool> pool, size_t capacity)
+        : pool_(std::move(pool))
+        , capacity_(capacity)
+        , bytes_(new uint8_t[capacity])
+    {}
+
+    uint8_t* bytes() { return bytes_.get(); }
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Free a page that is not referenced
+     */
+    void destroy() { delete this; }
+
+protected:
+    void onUnreferenced() override {
+        Pool& pool = *pool_;
+
+        // Oversized pages are never reused
+        if (pool.open && capacity_ == pool.page_size &&
+            pool.free_pages.size() < pool.max_free_pages) {
+            pool.free_pages.push_back(this);
+        } else {
+            delete this;
+        }
+    }
+
+private:
+    std::shared_ptr<Pool>       pool_;
+    size_t                      capacity_;
+    std::unique_ptr<uint8_t[]>  bytes_;
+};
+
+// ============================================================================
+// PayloadArena Implementation
+// ============================================================================
+
+PayloadArena::PayloadArena(size_t page_size, size_t max_free_pages)
+    : pool_(std::make_shared<Pool>())
+    , cursor_(nullptr)
+    , limit_(nullptr)
+{
+    pool_->page_size = std::max<size_t>(page_size, 1);
+    pool_->max_free_pages = max_free_pages;
+    pool_->page_allocations = 0;
+    pool_->open = true;
+    pool_->free_pages.reserve(max_free_pages);
+}
+
+PayloadArena::~PayloadArena() {
+    current_.reset();
+
+    // Referenced pages free themselves once the pool is closed
+    pool_->open = false;
+    for (Page* page : pool_->free_pages) {
+        page->destroy();
+    }
+    pool_->free_pages.clear();
+}
+
+const uint8_t* PayloadArena::storeInNewPage(const uint8_t* data, size_t length,
+                                            PayloadBlockRef& block) {
+    if (length > pool_->page_size) {
+        // Dedicated page; the current page stays open for small segments
+        Page* page = takePage(length);
+        block = PayloadBlockRef(page);
+        std::memcpy(page->bytes(), data, length);
+        return page->bytes();
+    }
+
+    Page* page = takePage(pool_->page_size);
+    current_ = PayloadBlockRef(page);
+    cursor_ = page->bytes();
+    limit_ = page->bytes() + page->capacity();
+
+    uint8_t* destination = cursor_;
+    std::memcpy(destination, data, length);
+    cursor_ += length;
+
+    block = current_;
+    return destination;
+}
+
+PayloadArena::Page* PayloadArena::takePage(size_t capacity) {
+    if (capacity == pool_->page_size && !pool_->free_pages.empty()) {
+        Page* page = pool_->free_pages.back();
+        pool_->free_pages.pop_back();
+        return page;
+    }
+
+    pool_->page_allocations++;
+    return new Page(pool_, capacity);
+}
+
+size_t PayloadArena::getPageSize() const {
+    return pool_->page_size;
+}
+
+size_t PayloadArena::getPageAllocations() const {
+    return pool_->page_allocations;
+}
+
+size_t PayloadArena::getFreePageCount() const {
+    return pool_->free_pages.size();
+}
+
+} // namespace mpegts
@@ -0,0 +1,253 @@
+#include "mpegts_batch.hpp"
+#include "mpegts_simd.hpp"
+#include <algorithm>
+
+namespace mpegts {
+
+namespace {
+
+// ============================================================================
+// Kernels
+//
+// Each kernel decodes packets [first, count) into the batch arrays and
+// ORs the flag bits into the masks, which the caller has cleared.
+// ============================================================================
+
+void decodeScalar(const uint8_t* data, size_t first, size_t count, size_t stride,
+                  PacketHeaderBatch& batch) {
+    for (size_t i = first; i < count; ++i) {
+        const uint8_t* packet = data + i * stride;
+        const uint32_t bit = uint32_t(1) << i;
+
+        batch.sync_mask |= (packet[0] == MPEGTS_SYNC_BYTE) ? bit : 0;
+        batch.tei_mask |= (packet[1] & 0x80) ? bit : 0;
+        batch.pusi_mask |= (packet[1] & 0x40) ? bit : 0;
+        batch.priority_mask |= (packet[1] & 0x20) ? bit : 0;
+
+        batch.pid[i] = readPID(packet);
+        batch.scrambling_control[i] = (packet[3] >> 6) & 0x03;
+        batch.adaptation_control[i] = (packet[3] >> 4) & 0x03;
+        batch.continuity_counter[i] = packet[3] & 0x0F;
+    }
+}
+
+#if defined(MPEGTS_SIMD_X86)
+
+MPEGTS_TARGET("avx2")
+void decodeAVX2(const uint8_t* data, size_t count, size_t stride,
+                PacketHeaderBatch& batch) {
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                               _mm256_set1_epi32(static_cast<int>(stride)));
+
+    // Transpose 4 header words per 128-bit lane into byte columns, then
+    // interleave the lanes: b0[0..7] b1[0..7] b2[0..7] b3[0..7]
+    const __m256i columns = _mm256_setr_epi8(
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m256i lanes = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    const __m128i sync = _mm_set1_epi8(static_cast<char>(MPEGTS_SYNC_BYTE));
+    const __m128i pid_high_mask = _mm_set1_epi8(0x1F);
+    const __m128i two_bits = _mm_set1_epi8(0x03);
+    const __m128i four_bits = _mm_set1_epi8(0x0F);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int* base = reinterpret_cast<const int*>(data + i * stride);
+        __m256i words = _mm256_i32gather_epi32(base, offsets, 1);
+        __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(words, columns), lanes);
+
+        __m128i b01 = _mm256_castsi256_si128(bytes);         // b0 | b1
+        __m128i b23 = _mm256_extracti128_si256(bytes, 1);    // b2 | b3
+        __m128i b1 = _mm_srli_si128(b01, 8);
+        __m128i b3 = _mm_srli_si128(b23, 8);
+
+        // Flag masks: sync byte compare, then bits 7/6/5 of byte 1
+        const uint32_t sync_bits = _mm_movemask_epi8(_mm_cmpeq_epi8(b01, sync)) & 0xFF;
+        const uint32_t tei_bits = _mm_movemask_epi8(b1) & 0xFF;
+        const uint32_t pusi_bits = _mm_movemask_epi8(_mm_slli_epi16(b1, 1)) & 0xFF;
+        const uint32_t priority_bits = _mm_movemask_epi8(_mm_slli_epi16(b1, 2)) & 0xFF;
+
+        batch.sync_mask |= sync_bits << i;
+        batch.tei_mask |= tei_bits << i;
+        batch.pusi_mask |= pusi_bits << i;
+        batch.priority_mask |= priority_bits << i;
+
+        // PID: byte 2 low, byte 1 & 0x1F high
+        __m128i pid = _mm_unpacklo_epi8(b23, _mm_and_si128(b1, pid_high_mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(batch.pid + i), pid);
+
+        // Byte 3: scrambling[7:6], adaptation control[5:4], CC[3:0]
+        __m128i scrambling = _mm_and_si128(_mm_srli_epi16(b3, 6), two_bits);
+        __m128i adaptation = _mm_and_si128(_mm_srli_epi16(b3, 4), two_bits);
+        __m128i cc = _mm_and_si128(b3, four_bits);
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(batch.scrambling_control + i), scrambling);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(batch.adaptation_control + i), adaptation);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(batch.continuity_counter + i), cc);
+    }
+
+    decodeScalar(data, i, count, stride, batch);
+}
+
+#endif // MPEGTS_SIMD_X86
+
+// ============================================================================
+// Continuity Kernels
+//
+// Each kernel compares the counters of all HEADER_BATCH_SIZE lanes with
+// the previous counters and returns two masks: in_sequence (counter is
+// previous + 1 for payload packets, unchanged otherwise) and repeated
+// (payload packet with an unchanged counter).
+// ============================================================================
+
+void compareContinuityScalar(const PacketHeaderBatch& batch, const uint8_t* previous,
+                             uint32_t& in_sequence, uint32_t& repeated) {
+    in_sequence = 0;
+    repeated = 0;
+
+    for (size_t i = 0; i < HEADER_BATCH_SIZE; ++i) {
+        const uint32_t bit = uint32_t(1) << i;
+        const uint8_t has_payload = batch.adaptation_control[i] & 0x01;
+        const uint8_t cc = batch.continuity_counter[i];
+
+        in_sequence |= (cc == ((previous[i] + has_payload) & 0x0F)) ? bit : 0;
+        repeated |= (has_payload && cc == previous[i]) ? bit : 0;
+    }
+}
+
+#if defined(MPEGTS_SIMD_X86)
+
+MPEGTS_TARGET("sse2")
+void compareContinuitySSE2(const PacketHeaderBatch& batch, const uint8_t* previous,
+                           uint32_t& in_sequence, uint32_t& repeated) {
+    const __m128i one = _mm_set1_epi8(0x01);
+    const __m128i four_bits = _mm_set1_epi8(0x0F);
+
+    in_sequence = 0;
+    repeated = 0;
+
+    for (size_t i = 0; i < HEADER_BATCH_SIZE; i += 16) {
+        __m128i prev = _mm_load_si128(reinterpret_cast<const __m128i*>(previous + i));
+        __m128i cc = _mm_load_si128(reinterpret_cast<const __m128i*>(batch.continuity_counter + i));
+        __m128i afc = _mm_load_si128(reinterpret_cast<const __m128i*>(batch.adaptation_control + i));
+
+        // Payload bit of adaptation_field_control: 0 or 1 per lane
+        __m128i payload = _mm_and_si128(afc, one);
+        __m128i expected = _mm_and_si128(_mm_add_epi8(prev, payload), four_bits);
+
+        __m128i same = _mm_and_si128(_mm_cmpeq_epi8(cc, prev), _mm_cmpeq_epi8(payload, one));
+
+        in_sequence |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(cc, expected))) << i;
+        repeated |= static_cast<uint32_t>(_mm_movemask_epi8(same)) << i;
+    }
+}
+
+#endif // MPEGTS_SIMD_X86
+
+} // namespace
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+size_t decodeHeaders(const uint8_t* data, size_t n, PacketHeaderBatch& batch, size_t stride) {
+    return decodeHeaders(detectSyncScanKernel(), data, n, batch, stride);
+}
+
+size_t decodeHeaders(SyncScanKernel kernel, const uint8_t* data, size_t n,
+                     PacketHeaderBatch& batch, size_t stride) {
+    batch.sync_mask = 0;
+    batch.tei_mask = 0;
+    batch.pusi_mask = 0;
+    batch.priority_mask = 0;
+    batch.count = (data != nullptr) ? std::min(n, HEADER_BATCH_SIZE) : 0;
+
+    switch (kernel) {
+#if defined(MPEGTS_SIMD_X86)
+        case SyncScanKernel::AVX512:
+        case SyncScanKernel::AVX2:
+            decodeAVX2(data, batch.count, stride, batch);
+            break;
+#endif
+        default:
+            decodeScalar(data, 0, batch.count, stride, batch);
+            break;
+    }
+
+    return batch.count;
+}
+
+void checkContinuity(const PacketHeaderBatch& batch, uint32_t packet_mask,
+                     uint32_t indicator_mask, PIDStateTable& states,
+                     ContinuityResult& result) {
+    checkContinuity(detectSyncScanKernel(), batch, packet_mask, indicator_mask, states, result);
+}
+
+void checkContinuity(SyncScanKernel kernel, const PacketHeaderBatch& batch,
+                     uint32_t packet_mask, uint32_t indicator_mask,
+                     PIDStateTable& states, ContinuityResult& result) {
+    result = ContinuityResult();
+
+    if (batch.count < HEADER_BATCH_SIZE) {
+        packet_mask &= (uint32_t(1) << batch.count) - 1;
+    }
+    if (packet_mask == 0) {
+        return;
+    }
+
+    // Gather pass: previous counter per packet, state updated in packet
+    // order. This is the only part that depends on the PID. A counter may
+    // be repeated once; the state remembers a repeat so a second one is
+    // caught, even across batches
+    alignas(16) uint8_t previous[HEADER_BATCH_SIZE] = {};
+    uint32_t known_mask = 0;
+    uint32_t repeated_again = 0;
+
+    for (uint32_t pending = packet_mask; pending != 0; pending &= pending - 1) {
+        const size_t i = detail::countTrailingZeros(pending);
+        const uint8_t cc = batch.continuity_counter[i];
+        PIDState& state = states[batch.pid[i]];
+
+        bool repeats = false;
+        if (state.flags & PID_STATE_CC_VALID) {
+            previous[i] = state.last_cc;
+            known_mask |= uint32_t(1) << i;
+            repeats = (batch.adaptation_control[i] & 0x01) && cc == state.last_cc;
+        }
+        if (repeats && (state.flags & PID_STATE_REPEATED)) {
+            repeated_again |= uint32_t(1) << i;
+        }
+
+        state.last_cc = cc;
+        state.flags = static_cast<uint8_t>(
+            (state.flags & ~PID_STATE_REPEATED) | PID_STATE_CC_VALID |
+            (repeats ? PID_STATE_REPEATED : 0));
+    }
+
+    // Compare pass: all lanes at once
+    uint32_t in_sequence;
+    uint32_t repeated;
+
+    switch (kernel) {
+#if defined(MPEGTS_SIMD_X86)
+        case SyncScanKernel::AVX512:
+        case SyncScanKernel::AVX2:
+        case SyncScanKernel::SSE2:
+            compareContinuitySSE2(batch, previous, in_sequence, repeated);
+            break;
+#endif
+        default:
+            compareContinuityScalar(batch, previous, in_sequence, repeated);
+            break;
+    }
+
+    const uint32_t broken = packet_mask & known_mask & ~in_sequence;
+    const uint32_t duplicate = repeated & ~repeated_again;
+
+    result.discontinuity_mask = broken & indicator_mask;
+    result.duplicate_mask = broken & duplicate & ~indicator_mask;
+    result.error_mask = broken & ~duplicate & ~indicator_mask;
+}
+
+} // namespace mpegts
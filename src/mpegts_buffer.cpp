@@ -0,0 +1,64 @@
+#include "mpegts_buffer.hpp"
+#include <cstring>
+
+namespace mpegts {
+
+IngestBuffer::IngestBuffer(size_t capacity)
+    : storage_(capacity * 2)
+    , capacity_(capacity)
+    , read_pos_(0)
+    , write_pos_(0)
+{
+}
+
+void IngestBuffer::append(const uint8_t* data, size_t length) {
+    if (!data || length == 0) {
+        return;
+    }
+
+    // Input alone fills the buffer: keep only its newest bytes
+    if (length >= capacity_) {
+        std::memcpy(storage_.data(), data + (length - capacity_), capacity_);
+        read_pos_ = 0;
+        write_pos_ = capacity_;
+        return;
+    }
+
+    // Drop oldest bytes by advancing the read offset
+    if (size() + length > capacity_) {
+        read_pos_ += size() + length - capacity_;
+    }
+
+    // Compact only when the new data would run past the storage end
+    if (write_pos_ + length > storage_.size()) {
+        compact();
+    }
+
+    std::memcpy(storage_.data() + write_pos_, data, length);
+    write_pos_ += length;
+}
+
+void IngestBuffer::consume(size_t length) {
+    if (length >= size()) {
+        clear();
+        return;
+    }
+
+    read_pos_ += length;
+}
+
+void IngestBuffer::clear() {
+    read_pos_ = 0;
+    write_pos_ = 0;
+}
+
+void IngestBuffer::compact() {
+    size_t remaining = size();
+    if (read_pos_ > 0 && remaining > 0) {
+        std::memmove(storage_.data(), storage_.data() + read_pos_, remaining);
+    }
+    read_pos_ = 0;
+    write_pos_ = remaining;
+}
+
+} // namespace mpegts
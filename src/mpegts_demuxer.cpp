@@ -1,199 +1,394 @@
 #include "mpegts_demuxer.hpp"
+#include "mpegts_sync.hpp"
+#include "mpegts_pes.hpp"
+#include "mpegts_simd.hpp"
 #include <algorithm>
 #include <cstring>
 
 namespace mpegts {
 
-MPEGTSDemuxer::MPEGTSDemuxer()
-    : is_synchronized_(false)
+namespace {
+
+// Packets after a candidate searched for its validation packets
+constexpr size_t SYNC_SEARCH_PACKETS = 10;
+
+// Bytes handed to feedData() per mapped file window
+constexpr size_t FILE_WINDOW_SIZE = 1024 * 1024;
+
+// Smallest ingest buffer that always holds a full resync search and a run
+// of unresolved sync misses at the largest stride, so a full buffer can
+// always make progress
+size_t minBufferCapacity(const DemuxerConfig& config) {
+    size_t packets = std::max<size_t>({config.sync_acquire_count, config.sync_loss_count,
+                                       SYNC_SEARCH_PACKETS});
+    return RS_PACKET_SIZE * packets * 2;
+}
+
+} // namespace
+
+DemuxerCore::DemuxerCore(const DemuxerConfig& config)
+    : iteration_sink_(nullptr)
+    , reference_payloads_(false)
+    , raw_buffer_(std::max(config.buffer_capacity, minBufferCapacity(config)))
+    , is_synchronized_(false)
     , sync_offset_(0)
-    , sync_validation_depth_(3)
+    , sync_validation_depth_(std::max<uint8_t>(config.sync_acquire_count, 1))
+    , sync_loss_threshold_(std::max<uint8_t>(config.sync_loss_count, 1))
+    , prefetch_distance_(std::min<uint8_t>(config.prefetch_distance, HEADER_BATCH_SIZE - 1))
+    , tei_policy_(config.tei_policy)
+    , configured_format_(config.packet_format)
+    , packet_format_(PacketFormat::TS)
+    , packet_stride_(MPEGTS_PACKET_SIZE)
+    , sync_byte_offset_(0)
     , programs_table_available_(false)
+    , probe_pcr_(true)
+    , continuity_stats_(PID_COUNT)
     , total_packets_processed_(0)
+    , has_pcr_base_(false)
+    , last_pcr_base_(0)
 {
-    raw_buffer_.reserve(MAX_BUFFER_SIZE);
+    if (configured_format_ != PacketFormat::AUTO) {
+        setPacketFormat(configured_format_);
+    }
+
+    storage_.setRetentionPolicy(config.retention);
+    storage_.setArenaPageSize(config.arena_page_size);
+
+    rebuildPIDRoles();
 }
 
-MPEGTSDemuxer::~MPEGTSDemuxer() {
+DemuxerCore::~DemuxerCore() {
     // Finalize all pending iterations using safe method
     finalizeAllIterations();
 }
 
-void MPEGTSDemuxer::feedData(const uint8_t* data, size_t length) {
+size_t DemuxerCore::feedData(const uint8_t* data, size_t length) {
     if (!data || length == 0) {
-        return;
+        return 0;
     }
 
-    // Add data to buffer
-    raw_buffer_.insert(raw_buffer_.end(), data, data + length);
+    const uint8_t* const begin = data;
 
-    // Prevent buffer overflow
-    if (raw_buffer_.size() > MAX_BUFFER_SIZE) {
-        // TODO: Implement proper buffer management
-        // For now, keep only the last MAX_BUFFER_SIZE bytes
-        size_t overflow = raw_buffer_.size() - MAX_BUFFER_SIZE;
-        raw_buffer_.erase(raw_buffer_.begin(), raw_buffer_.begin() + overflow);
-    }
+    // Input larger than the buffer is taken in slices; each slice is
+    // processed before the next is buffered, so no byte is overwritten
+    while (length > 0) {
+        // Complete the partial packet carried over from the previous call
+        if (is_synchronized_ && !raw_buffer_.empty()) {
+            size_t partial = raw_buffer_.size() % packet_stride_;
+            size_t needed = (partial > 0) ? packet_stride_ - partial : 0;
+            size_t take = std::min(needed, length);
 
-    // Process buffer
-    processBuffer();
-}
+            raw_buffer_.append(data, take);
+            data += take;
+            length -= take;
 
-void MPEGTSDemuxer::processBuffer() {
-    // Try to find valid iteration if not synchronized
-    if (!is_synchronized_) {
-        if (tryFindValidIteration()) {
-            is_synchronized_ = true;
-            // Continue processing after finding sync
-        } else {
-            return; // Wait for synchronization
+            processBuffer();
         }
-    }
 
-    // Process synchronized packets
-    while (sync_offset_ + MPEGTS_PACKET_SIZE <= raw_buffer_.size()) {
-        const uint8_t* packet_data = &raw_buffer_[sync_offset_];
+        // Zero-copy path: parse whole packets directly from caller's memory
+        // (payloads of a block from feedBlock() are referenced, not copied)
+        if (is_synchronized_ && raw_buffer_.empty()) {
+            reference_payloads_ = static_cast<bool>(ingest_block_);
+            size_t consumed = processPackets(data, length);
+            reference_payloads_ = false;
 
-        // Validate sync byte
-        if (packet_data[0] != MPEGTS_SYNC_BYTE) {
-            // Lost synchronization
-            is_synchronized_ = false;
-            sync_offset_ = 0;
-            return;
+            data += consumed;
+            length -= consumed;
         }
 
-        // Parse packet
-        TSPacket packet;
-        if (!packet.parse(packet_data) || !packet.isValid()) {
-            // Invalid packet, try to resync
-            is_synchronized_ = false;
-            sync_offset_ = 0;
-            return;
+        if (length == 0) {
+            break;
         }
 
-        // Process PSI packets (PAT/PMT)
-        processPSIPacket(packet);
+        // Carry over the partial tail packet or the bytes needed for
+        // resync, never more than the buffer has room for
+        size_t take = std::min(length, raw_buffer_.available());
+        if (take == 0) {
+            break; // Backpressure: the rest must be fed again
+        }
+
+        raw_buffer_.append(data, take);
+        data += take;
+        length -= take;
+
+        // Process buffer (resync, or packets held back by unresolved sync misses)
+        if (!is_synchronized_ || raw_buffer_.size() >= packet_stride_) {
+            processBuffer();
+        }
+    }
+
+    return static_cast<size_t>(data - begin);
+}
+
+size_t DemuxerCore::feedBlock(const PayloadBlockRef& block, const uint8_t* data,
+                              size_t length) {
+    ingest_block_ = block;
+    size_t consumed = feedData(data, length);
+    ingest_block_.reset();
+
+    return consumed;
+}
 
-        // Process PCR if present
-        processPCR(packet);
+size_t DemuxerCore::feedFile(MappedSource& source) {
+    size_t total = 0;
 
-        // Add packet to storage (accumulates in current iteration)
-        addPacketToStorage(packet);
+    while (!source.atEnd()) {
+        // Re-read the stride each time: detection may change it on resync
+        const uint8_t* window = nullptr;
+        size_t length = source.nextWindow(window, FILE_WINDOW_SIZE, packet_stride_);
 
-        // Move to next packet
-        sync_offset_ += MPEGTS_PACKET_SIZE;
-        total_packets_processed_++;
+        size_t consumed = feedData(window, length);
+        if (consumed == 0) {
+            break;
+        }
+
+        source.advance(consumed);
+        total += consumed;
     }
 
-    // Clean up processed data from buffer
-    if (sync_offset_ > 0) {
-        raw_buffer_.erase(raw_buffer_.begin(), raw_buffer_.begin() + sync_offset_);
-        sync_offset_ = 0;
+    return total;
+}
+
+bool DemuxerCore::feedFile(const std::string& path) {
+    MappedSource source;
+    if (!source.open(path)) {
+        return false;
     }
+
+    // The demuxer may refuse a window under backpressure; what it did not
+    // take was never fed
+    feedFile(source);
+    return source.atEnd();
 }
 
-bool MPEGTSDemuxer::tryFindValidIteration() {
-    // 3-iteration validation algorithm
-    // We need to find at least 3 valid packets to confirm synchronization
+void DemuxerCore::processBuffer() {
+    // A lost lock rewinds to the first missed slot, which is never a sync
+    // byte, so every resync below starts further into the buffer
+    do {
+        // Try to find valid iteration if not synchronized
+        if (!is_synchronized_) {
+            if (tryFindValidIteration()) {
+                is_synchronized_ = true;
+                stats_.sync_acquisitions++;
+                // Continue processing after finding sync
+            } else {
+                return; // Wait for synchronization
+            }
+        }
 
-    const size_t min_buffer_for_sync = MPEGTS_PACKET_SIZE * 3;
-    const size_t buffer_size = raw_buffer_.size(); // Cache size to avoid repeated calls
+        // Process synchronized packets (the first pass after a resync
+        // reuses the packets parsed by validation)
+        sync_offset_ += processPackets(raw_buffer_.data() + sync_offset_,
+                                       raw_buffer_.size() - sync_offset_);
+        validated_packets_.clear();
 
-    if (buffer_size < min_buffer_for_sync) {
-        return false; // Not enough data
+        // Clean up processed data from buffer (on sync loss or unresolved
+        // misses the first missed slot stays at the front)
+        if (sync_offset_ > 0) {
+            raw_buffer_.consume(sync_offset_);
+            sync_offset_ = 0;
+        }
+    } while (!is_synchronized_);
+}
+
+void DemuxerCore::countContinuity(const PacketHeaderBatch& batch,
+                                  const ContinuityResult& result) {
+    for (uint32_t pending = result.error_mask; pending != 0; pending &= pending - 1) {
+        continuity_stats_[batch.pid[detail::countTrailingZeros(pending)]].cc_errors++;
+        stats_.cc_errors++;
+    }
+    for (uint32_t pending = result.duplicate_mask; pending != 0; pending &= pending - 1) {
+        continuity_stats_[batch.pid[detail::countTrailingZeros(pending)]].duplicates++;
+        stats_.cc_duplicates++;
     }
+    for (uint32_t pending = result.discontinuity_mask; pending != 0; pending &= pending - 1) {
+        continuity_stats_[batch.pid[detail::countTrailingZeros(pending)]].discontinuities++;
+        stats_.cc_discontinuities++;
+    }
+}
+
+bool DemuxerCore::tryFindValidIteration() {
+    // N-iteration validation algorithm (N = sync_acquire_count, default 3)
+    // We need to find at least N valid packets to confirm synchronization
+
+    const size_t buffer_size = raw_buffer_.size(); // Cache size to avoid repeated calls
 
     // Get direct pointer to buffer data for faster access
     const uint8_t* buffer_data = raw_buffer_.data();
 
-    // Scan for potential sync positions
+    // Re-detect the framing on every resync: the stride with the most
+    // periodic sync bytes wins, otherwise the previous format is kept
+    if (configured_format_ == PacketFormat::AUTO) {
+        PacketFormat detected = detectPacketFormat(buffer_data, buffer_size);
+        if (detected != PacketFormat::AUTO) {
+            setPacketFormat(detected);
+        }
+    }
+
+    const size_t stride = packet_stride_;
+    const size_t min_buffer_for_sync = stride * sync_validation_depth_;
+
+    if (buffer_size < min_buffer_for_sync) {
+        return false; // Not enough data
+    }
+
+    // Scan sync bytes through a view shifted by sync_byte_offset_, so that
+    // every position below is also the start of its unit in raw_buffer_
+    const uint8_t* scan_data = buffer_data + sync_byte_offset_;
+    const size_t scan_size = buffer_size - sync_byte_offset_;
     const size_t max_start_pos = buffer_size - min_buffer_for_sync;
-    for (size_t start_pos = 0; start_pos <= max_start_pos; ++start_pos) {
+    const size_t search_window = stride * SYNC_SEARCH_PACKETS;
+
+    // Fast pass: the vectorized scanner only yields positions where the
+    // sync byte repeats at +stride and +2*stride, so most false sync bytes
+    // are rejected before any header is parsed
+    size_t start_pos = 0;
+    while (start_pos <= max_start_pos) {
+        size_t found = findSyncCandidate(scan_data + start_pos, scan_size - start_pos, stride);
+        if (found == scan_size - start_pos) {
+            break;
+        }
 
-        // Check for sync byte at this position
-        if (buffer_data[start_pos] != MPEGTS_SYNC_BYTE) {
-            continue;
+        start_pos += found;
+        if (start_pos > max_start_pos) {
+            break;
+        }
+
+        if (validateSyncPosition(scan_data, scan_size, start_pos)) {
+            // Found valid synchronization point!
+            sync_offset_ = start_pos;
+            return true;
+        }
+
+        ++start_pos;
+    }
+
+    // Fallback pass: packets separated by garbage are not on the packet
+    // grid, so try every remaining sync byte with the adaptive search
+    for (start_pos = 0; start_pos <= max_start_pos; ++start_pos) {
+        const void* next = std::memchr(scan_data + start_pos, MPEGTS_SYNC_BYTE,
+                                       max_start_pos + 1 - start_pos);
+        if (!next) {
+            break;
         }
+        start_pos = static_cast<const uint8_t*>(next) - scan_data;
 
-        // Try to parse first packet
-        TSPacket packet1;
-        if (!packet1.parse(&buffer_data[start_pos]) || !packet1.isValid()) {
+        // Periodic candidates were already rejected by the fast pass
+        if (start_pos + stride * 2 < scan_size &&
+            scan_data[start_pos + stride] == MPEGTS_SYNC_BYTE &&
+            scan_data[start_pos + stride * 2] == MPEGTS_SYNC_BYTE) {
             continue;
         }
 
-        // Search for second valid packet (adaptive search)
-        std::vector<TSPacket> candidates;
-        candidates.reserve(sync_validation_depth_); // Pre-allocate to avoid reallocation
-        candidates.push_back(packet1);
+        if (validateSyncPosition(scan_data, scan_size, start_pos)) {
+            sync_offset_ = start_pos;
+            return true;
+        }
+    }
 
-        size_t search_pos = start_pos + 1;
-        const size_t max_search = std::min(start_pos + MPEGTS_PACKET_SIZE * 10, buffer_size);
+    // A rejected position is final once its whole search window was
+    // available. Everything before the first sync byte whose window is
+    // still incomplete can never start a valid packet: drop it, so the
+    // next feed resumes there instead of rescanning from byte 0
+    size_t keep_from = max_start_pos + 1;
+    size_t undecided_from = (scan_size > search_window)
+        ? scan_size - search_window + 1
+        : 0;
+
+    if (undecided_from < keep_from) {
+        const void* pending = std::memchr(scan_data + undecided_from, MPEGTS_SYNC_BYTE,
+                                          keep_from - undecided_from);
+        if (pending) {
+            keep_from = static_cast<const uint8_t*>(pending) - scan_data;
+        }
+    }
 
-        while (candidates.size() < static_cast<size_t>(sync_validation_depth_) &&
-               search_pos + MPEGTS_PACKET_SIZE <= max_search) {
+    // Positions are unit starts, so an M2TS timestamp before the kept sync
+    // byte stays in the buffer
+    raw_buffer_.consume(keep_from);
 
-            if (buffer_data[search_pos] == MPEGTS_SYNC_BYTE) {
-                TSPacket packet_candidate;
+    return false; // No valid sync position found
+}
 
-                if (packet_candidate.parse(&buffer_data[search_pos]) &&
-                    packet_candidate.isValid()) {
+void DemuxerCore::setPacketFormat(PacketFormat format) {
+    packet_format_ = format;
+    packet_stride_ = getPacketStride(format);
+    sync_byte_offset_ = getSyncByteOffset(format);
+}
+
+bool DemuxerCore::validateSyncPosition(const uint8_t* buffer_data, size_t buffer_size,
+                                       size_t start_pos) {
+    // Parsed candidates are kept (offsets relative to start_pos) so that
+    // processPackets() does not decode them a second time after lock
+    auto& candidates = validated_packets_;
+    candidates.clear();
+
+    // Try to parse first packet
+    // Packets flagged by the demodulator do not count towards lock
+    candidates.emplace_back();
+    TSPacket& packet1 = candidates.back().packet;
+    if (!packet1.parse(&buffer_data[start_pos]) || !packet1.isValid() ||
+        packet1.getHeader().transport_error_indicator) {
+        candidates.clear();
+        return false;
+    }
 
-                    // Check if belongs to same iteration
-                    if (candidates.empty() ||
-                        belongsToSameIteration(candidates.back(), packet_candidate)) {
+    // Search for second valid packet (adaptive search)
+    size_t search_pos = start_pos + 1;
+    const size_t max_search = std::min(start_pos + packet_stride_ * SYNC_SEARCH_PACKETS,
+                                       buffer_size);
 
-                        candidates.push_back(packet_candidate);
+    while (candidates.size() < static_cast<size_t>(sync_validation_depth_) &&
+           search_pos + MPEGTS_PACKET_SIZE <= max_search) {
 
-                        // After finding valid packet, assume next is 188 bytes away
-                        search_pos += MPEGTS_PACKET_SIZE;
-                        continue;
-                    }
-                }
-            }
+        if (buffer_data[search_pos] == MPEGTS_SYNC_BYTE) {
+            TSPacket packet_candidate;
 
-            // Adaptive skip: move one byte forward
-            search_pos++;
-        }
+            if (packet_candidate.parse(&buffer_data[search_pos]) &&
+                packet_candidate.isValid() &&
+                !packet_candidate.getHeader().transport_error_indicator) {
 
-        // Check if we found 3 valid packets
-        const size_t candidates_count = candidates.size();
-        if (candidates_count >= static_cast<size_t>(sync_validation_depth_)) {
-            // Verify they form a consistent sequence
-            bool valid_sequence = true;
+                // Check if belongs to same iteration
+                if (belongsToSameIteration(candidates.back().packet, packet_candidate)) {
+                    candidates.push_back({search_pos - start_pos, packet_candidate});
 
-            for (size_t i = 1; i < candidates_count; ++i) {
-                if (!belongsToSameIteration(candidates[i-1], candidates[i])) {
-                    valid_sequence = false;
-                    break;
+                    // After finding valid packet, assume next is one unit away
+                    search_pos += packet_stride_;
+                    continue;
                 }
             }
-
-            if (valid_sequence) {
-                // Found valid synchronization point!
-                sync_offset_ = start_pos;
-                return true;
-            }
         }
+
+        // Adaptive skip: move one byte forward
+        search_pos++;
     }
 
-    return false; // No valid sync position found
+    // Check if we found 3 valid packets (each one was checked against its
+    // predecessor when it was added, so they form a consistent sequence)
+    if (candidates.size() < static_cast<size_t>(sync_validation_depth_)) {
+        candidates.clear();
+        return false;
+    }
+
+    return true;
 }
 
-bool MPEGTSDemuxer::validatePacket(const uint8_t* data) {
+bool DemuxerCore::validatePacket(const uint8_t* data) {
     if (!data) {
         return false;
     }
 
     TSPacket packet;
-    return packet.parse(data) && packet.isValid();
+    return packet.parse(data) && packet.isValid() &&
+           !packet.getHeader().transport_error_indicator;
 }
 
-bool MPEGTSDemuxer::belongsToSameIteration(const TSPacket& p1, const TSPacket& p2) {
+bool DemuxerCore::belongsToSameIteration(const TSPacket& p1, const TSPacket& p2) {
     const auto& h1 = p1.getHeader();
     const auto& h2 = p2.getHeader();
 
-    // Check continuity counter
-    uint8_t expected_cc = (h1.continuity_counter + 1) % 16;
+    // Check continuity counter (it only advances on packets with payload)
+    uint8_t expected_cc = (h1.continuity_counter + (p2.hasPayload() ? 1 : 0)) % 16;
     uint8_t actual_cc = h2.continuity_counter;
 
     if (actual_cc != expected_cc) {
@@ -212,27 +407,18 @@ bool MPEGTSDemuxer::belongsToSameIteration(const TSPacket& p1, const TSPacket& p
     return true;
 }
 
-void MPEGTSDemuxer::addPacketToStorage(const TSPacket& packet) {
+DemuxerCore::OpenIteration& DemuxerCore::currentIteration(const TSPacket& packet,
+                                                          bool cc_error, bool discontinuity) {
     const auto& header = packet.getHeader();
 
-    // Filter system PIDs
-    if (isSystemPID(header.pid)) {
-        return;
-    }
-
-    // Filter by program table if available
-    if (programs_table_available_) {
-        if (known_program_pids_.find(header.pid) == known_program_pids_.end()) {
-            return; // Unknown PID, skip
-        }
-    }
-
     uint16_t pid = header.pid;
 
+    PIDState& state = pid_states_[pid];
+
     // Check if we need to start a new iteration
     bool start_new_iteration = false;
 
-    if (current_iterations_.find(pid) == current_iterations_.end()) {
+    if (!(state.flags & PID_STATE_ITERATION)) {
         // First packet for this PID
         start_new_iteration = true;
     } else if (header.payload_unit_start) {
@@ -243,110 +429,114 @@ void MPEGTSDemuxer::addPacketToStorage(const TSPacket& packet) {
 
     // Start new iteration if needed
     if (start_new_iteration) {
-        current_iteration_ids_[pid] = storage_.generateIterationID();
-        current_iterations_[pid] = IterationData();
-        current_iterations_[pid].first_cc = header.continuity_counter;
-        current_iterations_[pid].payload_unit_start_seen = header.payload_unit_start;
+        state.iteration_slot = static_cast<uint32_t>(open_iterations_.size());
+        state.flags |= PID_STATE_ITERATION;
+
+        open_iterations_.push_back({pid, storage_.generateIterationID(),
+                                    &storage_.getArena(pid), IterationData()});
+        auto& started = open_iterations_.back().data;
+        started.payloads.reserve(state.segment_hint);
+        started.first_cc = header.continuity_counter;
+        started.payload_unit_start_seen = header.payload_unit_start;
+
+        // Start time for age-based retention: PTS of the PES header,
+        // else the most recent PCR of the multiplex
+        PESHeader pes;
+        if (header.payload_unit_start &&
+            PESParser::parseHeader(packet.getPayload(), packet.getPayloadSize(), pes) &&
+            pes.pts) {
+            started.has_timestamp = true;
+            started.timestamp = pes.pts->value;
+        } else if (has_pcr_base_) {
+            started.has_timestamp = true;
+            started.timestamp = last_pcr_base_;
+        }
     }
 
     // Get current iteration for this PID
-    auto& iter_data = current_iterations_[pid];
+    auto& iteration = open_iterations_[state.iteration_slot];
+    auto& iter_data = iteration.data;
 
     // Update metadata
     iter_data.last_cc = header.continuity_counter;
     iter_data.packet_count++;
 
-    // Check for discontinuity
-    if (last_cc_.find(pid) != last_cc_.end()) {
-        uint8_t expected_cc = (last_cc_[pid] + 1) % 16;
-        if (header.continuity_counter != expected_cc) {
-            const auto* adapt = packet.getAdaptationField();
-            if (adapt && adapt->discontinuity_indicator) {
-                iter_data.discontinuity_detected = true;
-            }
-        }
+    if (header.transport_error_indicator) {
+        iter_data.transport_error_detected = true;
     }
-    last_cc_[pid] = header.continuity_counter;
-
-    // Extract private data from adaptation field
-    if (packet.getPrivateDataLength() > 0) {
-        const uint8_t* private_data = packet.getPrivateData();
-        size_t private_len = packet.getPrivateDataLength();
 
-        // Store private data in buffer
-        size_t offset = iter_data.payload_data.size();
-        iter_data.payload_data.insert(iter_data.payload_data.end(),
-                                      private_data,
-                                      private_data + private_len);
-
-        // Create segment pointing to stored data
-        PayloadSegment private_segment;
-        private_segment.type = PayloadType::PAYLOAD_PRIVATE;
-        private_segment.data = nullptr; // Will be set after adding to storage
-        private_segment.length = private_len;
-        private_segment.offset_in_stream = offset;
-
-        iter_data.payloads.push_back(private_segment);
+    // Continuity verdicts come from the batch check
+    if (cc_error) {
+        iter_data.cc_error_detected = true;
+    }
+    if (discontinuity) {
+        iter_data.discontinuity_detected = true;
     }
 
-    // Extract normal payload
-    if (packet.hasPayload() && packet.getPayloadSize() > 0) {
-        const uint8_t* payload = packet.getPayload();
-        size_t payload_len = packet.getPayloadSize();
-
-        // Store payload data in buffer
-        size_t offset = iter_data.payload_data.size();
-        iter_data.payload_data.insert(iter_data.payload_data.end(),
-                                      payload,
-                                      payload + payload_len);
-
-        // Create segment pointing to stored data
-        PayloadSegment normal_segment;
-        normal_segment.type = PayloadType::PAYLOAD_NORMAL;
-        normal_segment.data = nullptr; // Will be set after adding to storage
-        normal_segment.length = payload_len;
-        normal_segment.offset_in_stream = offset;
+    return iteration;
+}
 
-        iter_data.payloads.push_back(normal_segment);
-    }
+void DemuxerCore::appendSegment(OpenIteration& iteration, PayloadType type,
+                                const uint8_t* data, size_t length,
+                                uint32_t arrival_timestamp) {
+    IterationData& iter_data = iteration.data;
+
+    // Reference the ingest block, or copy data into the stream's arena;
+    // either way the segment keeps the memory alive
+    PayloadSegment& segment = iter_data.payloads.emplace_back();
+    segment.type = type;
+    if (reference_payloads_) {
+        segment.data = data;
+        segment.block = ingest_block_;
+    } else {
+        segment.data = iteration.arena->store(data, length, segment.block);
+    }
+    segment.length = length;
+    segment.offset_in_stream = iter_data.payload_size;
+    segment.arrival_timestamp = arrival_timestamp;
+
+    iter_data.payload_size += length;
 }
 
-void MPEGTSDemuxer::finalizeIteration(uint16_t pid) {
-    auto it = current_iterations_.find(pid);
-    if (it == current_iterations_.end()) {
+void DemuxerCore::finalizeIteration(uint16_t pid) {
+    PIDState& state = pid_states_[pid];
+    if (!(state.flags & PID_STATE_ITERATION)) {
         return; // No current iteration
     }
 
-    // Add iteration to storage
-    auto& stream = storage_.getOrCreateStream(pid);
-    uint32_t iter_id = current_iteration_ids_[pid];
-    stream.addIteration(iter_id, it->second);
+    const uint32_t slot = state.iteration_slot;
+    auto& open = open_iterations_[slot];
 
-    // Clear current iteration
-    current_iterations_.erase(pid);
-    current_iteration_ids_.erase(pid);
-}
+    // Capacity reserved for the next iteration of this PID
+    state.segment_hint = static_cast<uint16_t>(std::min<size_t>(open.data.payloads.size(), 0xFFFF));
 
-void MPEGTSDemuxer::finalizeAllIterations() {
-    // Create a copy of PIDs to avoid iterator invalidation
-    std::vector<uint16_t> pids;
-    for (const auto& [pid, _] : current_iterations_) {
-        pids.push_back(pid);
+    // Hand the iteration to the sink, or add it to storage
+    if (iteration_sink_) {
+        iteration_sink_->onIterationComplete(pid, IterationView(open.id, open.data));
+    } else {
+        storage_.addIteration(pid, open.id, std::move(open.data));
     }
 
-    // Finalize each iteration
-    for (uint16_t pid : pids) {
-        finalizeIteration(pid);
+    // Clear current iteration: the last open iteration fills the slot
+    if (slot + 1 != open_iterations_.size()) {
+        open = std::move(open_iterations_.back());
+        pid_states_[open.pid].iteration_slot = slot;
     }
+    open_iterations_.pop_back();
+
+    state.flags &= ~PID_STATE_ITERATION;
 }
 
-void MPEGTSDemuxer::handleDiscontinuity(uint16_t pid) {
-    // TODO: Handle discontinuity detection
+void DemuxerCore::finalizeAllIterations() {
+    // Finalizing moves the last open iteration, so drain from the back
+    while (!open_iterations_.empty()) {
+        finalizeIteration(open_iterations_.back().pid);
+    }
 }
 
-std::vector<ProgramInfo> MPEGTSDemuxer::getPrograms() const {
+std::vector<ProgramInfo> DemuxerCore::getPrograms() const {
     // Finalize pending iterations first
-    const_cast<MPEGTSDemuxer*>(this)->finalizeAllIterations();
+    const_cast<DemuxerCore*>(this)->finalizeAllIterations();
 
     std::vector<ProgramInfo> programs;
 
@@ -405,16 +595,16 @@ std::vector<ProgramInfo> MPEGTSDemuxer::getPrograms() const {
     return programs;
 }
 
-std::set<uint16_t> MPEGTSDemuxer::getDiscoveredPIDs() const {
+std::set<uint16_t> DemuxerCore::getDiscoveredPIDs() const {
     // Finalize pending iterations first
-    const_cast<MPEGTSDemuxer*>(this)->finalizeAllIterations();
+    const_cast<DemuxerCore*>(this)->finalizeAllIterations();
 
     return storage_.getDiscoveredPIDs();
 }
 
-std::vector<IterationInfo> MPEGTSDemuxer::getIterationsSummary(uint16_t pid) const {
+std::vector<IterationInfo> DemuxerCore::getIterationsSummary(uint16_t pid) const {
     // Finalize pending iterations first
-    const_cast<MPEGTSDemuxer*>(this)->finalizeAllIterations();
+    const_cast<DemuxerCore*>(this)->finalizeAllIterations();
 
     std::vector<IterationInfo> result;
 
@@ -424,29 +614,13 @@ std::vector<IterationInfo> MPEGTSDemuxer::getIterationsSummary(uint16_t pid) con
     }
 
     for (const auto& [iter_id, iter_data] : stream->getIterations()) {
-        IterationInfo info;
-        info.iteration_id = iter_id;
-        info.has_discontinuity = iter_data.discontinuity_detected;
-        info.cc_start = iter_data.first_cc;
-        info.cc_end = iter_data.last_cc;
-        info.packet_count = iter_data.packet_count;
-
-        // Calculate payload sizes
-        for (const auto& payload : iter_data.payloads) {
-            if (payload.type == PayloadType::PAYLOAD_NORMAL) {
-                info.payload_normal_size += payload.length;
-            } else {
-                info.payload_private_size += payload.length;
-            }
-        }
-
-        result.push_back(info);
+        result.push_back(IterationView(iter_id, iter_data).getInfo());
     }
 
     return result;
 }
 
-PayloadBuffer MPEGTSDemuxer::getPayload(uint16_t pid, uint32_t iter_id, PayloadType type) const {
+PayloadBuffer DemuxerCore::getPayload(uint16_t pid, uint32_t iter_id, PayloadType type) const {
     PayloadBuffer buffer;
 
     const auto* stream = storage_.getStream(pid);
@@ -465,6 +639,7 @@ PayloadBuffer MPEGTSDemuxer::getPayload(uint16_t pid, uint32_t iter_id, PayloadT
             buffer.data = payload.data;
             buffer.length = payload.length;
             buffer.type = payload.type;
+            buffer.arrival_timestamp = payload.arrival_timestamp;
             break;
         }
     }
@@ -472,7 +647,7 @@ PayloadBuffer MPEGTSDemuxer::getPayload(uint16_t pid, uint32_t iter_id, PayloadT
     return buffer;
 }
 
-std::vector<PayloadBuffer> MPEGTSDemuxer::getAllPayloads(uint16_t pid, uint32_t iter_id) const {
+std::vector<PayloadBuffer> DemuxerCore::getAllPayloads(uint16_t pid, uint32_t iter_id) const {
     std::vector<PayloadBuffer> result;
 
     const auto* stream = storage_.getStream(pid);
@@ -491,108 +666,183 @@ std::vector<PayloadBuffer> MPEGTSDemuxer::getAllPayloads(uint16_t pid, uint32_t
         buffer.data = payload.data;
         buffer.length = payload.length;
         buffer.type = payload.type;
+        buffer.arrival_timestamp = payload.arrival_timestamp;
         result.push_back(buffer);
     }
 
     return result;
 }
 
-void MPEGTSDemuxer::clearIteration(uint16_t pid, uint32_t iter_id) {
+void DemuxerCore::clearIteration(uint16_t pid, uint32_t iter_id) {
     auto& stream = storage_.getOrCreateStream(pid);
     stream.removeIteration(iter_id);
 }
 
-void MPEGTSDemuxer::clearStream(uint16_t pid) {
+void DemuxerCore::clearStream(uint16_t pid) {
     storage_.clearStream(pid);
 }
 
-void MPEGTSDemuxer::clearAll() {
+void DemuxerCore::clearAll() {
     // Finalize all pending iterations
-    for (const auto& [pid, _] : current_iterations_) {
-        finalizeIteration(pid);
-    }
+    finalizeAllIterations();
 
     storage_.clear();
     raw_buffer_.clear();
     is_synchronized_ = false;
-    current_iterations_.clear();
-    current_iteration_ids_.clear();
-    last_cc_.clear();
+    pid_states_.reset();
+    has_pcr_base_ = false;
 }
 
-size_t MPEGTSDemuxer::getBufferOccupancy() const {
+size_t DemuxerCore::getBufferOccupancy() const {
     return raw_buffer_.size();
 }
 
-size_t MPEGTSDemuxer::getPacketCount() const {
-    return raw_buffer_.size() / MPEGTS_PACKET_SIZE;
+size_t DemuxerCore::getPacketCount() const {
+    return raw_buffer_.size() / packet_stride_;
 }
 
-void MPEGTSDemuxer::setProgramsTable(const ProgramTable& table) {
+void DemuxerCore::setProgramsTable(const ProgramTable& table) {
     programs_table_available_ = true;
     known_program_pids_.clear();
 
     for (const auto& [prog_num, pids] : table.programs) {
         for (uint16_t pid : pids) {
-            known_program_pids_.insert(pid);
+            known_program_pids_.set(pid);
         }
     }
 
-    // Clear existing data
+    rebuildPIDRoles();
+
+    // Clear existing data; open iterations are dropped with it, as they
+    // write into the arenas released by storage_.clear()
+    for (const auto& open : open_iterations_) {
+        pid_states_[open.pid].flags &= ~PID_STATE_ITERATION;
+    }
+    open_iterations_.clear();
     storage_.clear();
 }
 
-void MPEGTSDemuxer::processPSIPacket(const TSPacket& packet) {
-    const auto& header = packet.getHeader();
+void DemuxerCore::rebuildPIDRoles() {
+    // Payload: the program table PIDs, or without a table every PID
+    // except the system PIDs
+    if (programs_table_available_) {
+        pid_roles_.fill(PID_ROLE_IGNORED);
+        for (uint16_t pid = 0; pid < PID_COUNT; ++pid) {
+            if (known_program_pids_.test(pid)) {
+                pid_roles_.set(pid, PID_ROLE_PAYLOAD);
+            }
+        }
+    } else {
+        pid_roles_.fill(PID_ROLE_PAYLOAD);
+    }
 
-    // Check if this is a PAT packet (PID 0x0000)
-    if (header.pid == 0x0000 && packet.hasPayload()) {
-        const uint8_t* payload = packet.getPayload();
-        size_t payload_len = packet.getPayloadSize();
-
-        // Add data to PAT accumulator
-        if (pat_accumulator_.addData(payload, payload_len, header.payload_unit_start)) {
-            // Section complete, try to parse PAT
-            std::vector<uint8_t> section;
-            if (pat_accumulator_.getSection(section) > 0) {
-                PAT pat;
-                if (PSIParser::parsePAT(section.data(), section.size(), pat)) {
-                    // Successfully parsed PAT
-                    parsed_pat_ = pat;
-
-                    // Create accumulators for discovered PMT PIDs
-                    for (const auto& entry : pat.programs) {
-                        if (entry.program_number != 0) {  // Skip NIT
-                            pmt_accumulators_[entry.pid] = PSIAccumulator();
-                        }
-                    }
-                }
+    pid_roles_.set(PID_PAT, PID_ROLE_PAT);
+    pid_roles_.set(PID_CAT, PID_ROLE_IGNORED);
+    pid_roles_.set(PID_TSDT, PID_ROLE_IGNORED);
+    pid_roles_.set(PID_NULL, PID_ROLE_IGNORED);
+
+    // PSI: PMT PIDs announced by the PAT
+    if (parsed_pat_) {
+        for (const auto& entry : parsed_pat_->programs) {
+            if (entry.program_number != 0) {  // Skip NIT
+                pid_roles_.add(entry.pid, PID_ROLE_PMT);
             }
         }
     }
-    // Check if this is a PMT packet (discovered from PAT)
-    else if (pmt_accumulators_.find(header.pid) != pmt_accumulators_.end() &&
-             packet.hasPayload()) {
-        const uint8_t* payload = packet.getPayload();
-        size_t payload_len = packet.getPayloadSize();
-
-        // Add data to PMT accumulator
-        auto& pmt_acc = pmt_accumulators_[header.pid];
-        if (pmt_acc.addData(payload, payload_len, header.payload_unit_start)) {
-            // Section complete, try to parse PMT
-            std::vector<uint8_t> section;
-            if (pmt_acc.getSection(section) > 0) {
-                PMT pmt;
-                if (PSIParser::parsePMT(section.data(), section.size(), pmt)) {
-                    // Successfully parsed PMT
-                    parsed_pmts_[pmt.program_number] = pmt;
-                }
+
+    // PCR: the PIDs the PMTs name; until a PMT is known, any parsed PID
+    // may carry one, and ignored PIDs are probed for a PCR in the packet
+    // loop so they stay unparsed
+    probe_pcr_ = parsed_pmts_.empty();
+    if (probe_pcr_) {
+        for (uint16_t pid = 0; pid < PID_COUNT; ++pid) {
+            if (pid_roles_[pid] != PID_ROLE_IGNORED) {
+                pid_roles_.add(pid, PID_ROLE_PCR);
+            }
+        }
+    } else {
+        for (const auto& [prog_num, pmt] : parsed_pmts_) {
+            if (pmt.pcr_pid != PID_NULL) {
+                pid_roles_.add(pmt.pcr_pid, PID_ROLE_PCR);
             }
         }
     }
 }
 
-void MPEGTSDemuxer::processPCR(const TSPacket& packet) {
+void DemuxerCore::processPATPacket(const TSPacket& packet) {
+    if (!packet.hasPayload()) {
+        return;
+    }
+
+    const auto& header = packet.getHeader();
+
+    // Add data to PAT accumulator
+    if (!pat_accumulator_.addData(packet.getPayload(), packet.getPayloadSize(),
+                                  header.payload_unit_start)) {
+        return;
+    }
+
+    // Section complete, try to parse PAT
+    std::vector<uint8_t> section;
+    PAT pat;
+    if (pat_accumulator_.getSection(section) == 0 ||
+        !PSIParser::parsePAT(section.data(), section.size(), pat)) {
+        return;
+    }
+
+    // Repetitions of the current version change nothing
+    if (parsed_pat_ &&
+        parsed_pat_->header.version_number == pat.header.version_number &&
+        parsed_pat_->transport_stream_id == pat.transport_stream_id) {
+        return;
+    }
+
+    parsed_pat_ = pat;
+
+    // Create accumulators for discovered PMT PIDs
+    pmt_accumulators_.clear();
+    for (const auto& entry : pat.programs) {
+        if (entry.program_number != 0) {  // Skip NIT
+            pmt_accumulators_[entry.pid] = PSIAccumulator();
+        }
+    }
+
+    rebuildPIDRoles();
+}
+
+void DemuxerCore::processPMTPacket(const TSPacket& packet) {
+    auto acc_it = pmt_accumulators_.find(packet.getHeader().pid);
+    if (acc_it == pmt_accumulators_.end() || !packet.hasPayload()) {
+        return;
+    }
+
+    // Add data to PMT accumulator
+    auto& pmt_acc = acc_it->second;
+    if (!pmt_acc.addData(packet.getPayload(), packet.getPayloadSize(),
+                         packet.getHeader().payload_unit_start)) {
+        return;
+    }
+
+    // Section complete, try to parse PMT
+    std::vector<uint8_t> section;
+    PMT pmt;
+    if (pmt_acc.getSection(section) == 0 ||
+        !PSIParser::parsePMT(section.data(), section.size(), pmt)) {
+        return;
+    }
+
+    // Repetitions of the current version change nothing
+    auto pmt_it = parsed_pmts_.find(pmt.program_number);
+    if (pmt_it != parsed_pmts_.end() &&
+        pmt_it->second.header.version_number == pmt.header.version_number) {
+        return;
+    }
+
+    parsed_pmts_[pmt.program_number] = pmt;
+    rebuildPIDRoles();
+}
+
+void DemuxerCore::processPCR(const TSPacket& packet) {
     const auto& header = packet.getHeader();
 
     // Check if packet has adaptation field with PCR
@@ -608,6 +858,8 @@ void MPEGTSDemuxer::processPCR(const TSPacket& packet) {
     if (pcr.isValid()) {
         pcr_manager_.addPCR(header.pid, pcr,
                            total_packets_processed_, header.continuity_counter);
+        has_pcr_base_ = true;
+        last_pcr_base_ = adaptation->pcr_base;
     }
 }
 
@@ -615,7 +867,7 @@ void MPEGTSDemuxer::processPCR(const TSPacket& packet) {
 // PCR API Methods
 // ============================================================================
 
-std::optional<PCRStats> MPEGTSDemuxer::getPCRStats(uint16_t pid) const {
+std::optional<PCRStats> DemuxerCore::getPCRStats(uint16_t pid) const {
     const PCRTracker* tracker = pcr_manager_.getTracker(pid);
     if (tracker) {
         return tracker->getStats();
@@ -623,15 +875,15 @@ std::optional<PCRStats> MPEGTSDemuxer::getPCRStats(uint16_t pid) const {
     return std::nullopt;
 }
 
-std::vector<PCRStats> MPEGTSDemuxer::getAllPCRStats() const {
+std::vector<PCRStats> DemuxerCore::getAllPCRStats() const {
     return pcr_manager_.getAllStats();
 }
 
-std::vector<uint16_t> MPEGTSDemuxer::getPIDsWithPCR() const {
+std::vector<uint16_t> DemuxerCore::getPIDsWithPCR() const {
     return pcr_manager_.getPIDsWithPCR();
 }
 
-std::optional<PCR> MPEGTSDemuxer::getLastPCR(uint16_t pid) const {
+std::optional<PCR> DemuxerCore::getLastPCR(uint16_t pid) const {
     const PCRTracker* tracker = pcr_manager_.getTracker(pid);
     if (tracker) {
         return tracker->getLastPCR();
@@ -639,4 +891,10 @@ std::optional<PCR> MPEGTSDemuxer::getLastPCR(uint16_t pid) const {
     return std::nullopt;
 }
 
+// ============================================================================
+// Default Instantiation
+// ============================================================================
+
+template class BasicDemuxer<AutoPacketSize, AllPIDs, KeepAllPayloads>;
+
 } // namespace mpegts
@@ -13,6 +13,8 @@ TSPacket::TSPacket()
 }
 
 bool TSPacket::parse(const uint8_t* data) {
+    clearBody();
+
     if (!data) {
         valid_ = false;
         return false;
@@ -24,6 +26,32 @@ bool TSPacket::parse(const uint8_t* data) {
         return false;
     }
 
+    return parseBody(data);
+}
+
+bool TSPacket::parse(const uint8_t* data, const TSPacketHeader& header) {
+    clearBody();
+
+    if (!data || header.sync_byte != MPEGTS_SYNC_BYTE ||
+        header.adaptation_control == AdaptationFieldControl::RESERVED) {
+        valid_ = false;
+        return false;
+    }
+
+    header_ = header;
+    return parseBody(data);
+}
+
+void TSPacket::clearBody() {
+    // Reset state left by a previous parse (packets are reused)
+    adaptation_field_ = TSAdaptationField();
+    payload_data_ = nullptr;
+    payload_size_ = 0;
+    has_adaptation_ = false;
+    has_payload_ = false;
+}
+
+bool TSPacket::parseBody(const uint8_t* data) {
     size_t offset = 4; // After 4-byte header
 
     // Parse adaptation field if present
@@ -74,11 +102,7 @@ bool TSPacket::parseHeader(const uint8_t* data) {
     header_.adaptation_control = static_cast<AdaptationFieldControl>(adapt_ctrl);
     header_.continuity_counter = data[3] & 0x0F;
 
-    // Validate
-    if (header_.transport_error_indicator) {
-        return false;
-    }
-
+    // Validate (TEI packets are kept: the caller decides how to treat them)
     if (header_.adaptation_control == AdaptationFieldControl::RESERVED) {
         return false;
     }
@@ -102,10 +126,11 @@ bool TSPacket::parseAdaptationField(const uint8_t* data, size_t offset) {
         return false; // Adaptation field exceeds packet size
     }
 
-    size_t field_offset = offset + 1;
+    const uint8_t* field = data + offset + 1;
+    const uint8_t* const field_end = field + adaptation_field_.length;
 
     // Flags byte
-    uint8_t flags = data[field_offset++];
+    uint8_t flags = *field++;
     adaptation_field_.discontinuity_indicator = (flags >> 7) & 0x01;
     adaptation_field_.random_access_indicator = (flags >> 6) & 0x01;
     adaptation_field_.es_priority_indicator = (flags >> 5) & 0x01;
@@ -115,46 +140,99 @@ bool TSPacket::parseAdaptationField(const uint8_t* data, size_t offset) {
     adaptation_field_.transport_private_data_flag = (flags >> 1) & 0x01;
     adaptation_field_.adaptation_extension_flag = flags & 0x01;
 
+    // Fixed-size optional fields: the total size follows from the flags,
+    // so one bounds check covers PCR, OPCR, splice_countdown and the
+    // private data length byte
+    const size_t fixed_size = 6 * adaptation_field_.pcr_flag +
+                              6 * adaptation_field_.opcr_flag +
+                              adaptation_field_.splicing_point_flag +
+                              adaptation_field_.transport_private_data_flag;
+    if (fixed_size > static_cast<size_t>(field_end - field)) {
+        return false;
+    }
+
     // PCR (6 bytes)
     if (adaptation_field_.pcr_flag) {
-        if (field_offset + 6 > offset + 1 + adaptation_field_.length) {
-            return false;
-        }
-        // PCR parsing (simplified - not fully implemented yet)
-        field_offset += 6;
+        readClockReference(field, adaptation_field_.pcr_base, adaptation_field_.pcr_extension);
+        field += 6;
     }
 
     // OPCR (6 bytes)
     if (adaptation_field_.opcr_flag) {
-        if (field_offset + 6 > offset + 1 + adaptation_field_.length) {
-            return false;
-        }
-        field_offset += 6;
+        readClockReference(field, adaptation_field_.opcr_base, adaptation_field_.opcr_extension);
+        field += 6;
     }
 
-    // Splicing countdown (1 byte)
+    // Splicing countdown (1 byte, two's complement)
     if (adaptation_field_.splicing_point_flag) {
-        if (field_offset + 1 > offset + 1 + adaptation_field_.length) {
-            return false;
-        }
-        field_offset += 1;
+        adaptation_field_.splice_countdown = static_cast<int8_t>(*field++);
     }
 
     // Transport private data
     if (adaptation_field_.transport_private_data_flag) {
-        if (field_offset + 1 > offset + 1 + adaptation_field_.length) {
+        adaptation_field_.private_data_length = *field++;
+
+        if (adaptation_field_.private_data_length > field_end - field) {
             return false;
         }
 
-        adaptation_field_.private_data_length = data[field_offset++];
+        adaptation_field_.private_data = field;
+        field += adaptation_field_.private_data_length;
+    }
 
-        if (field_offset + adaptation_field_.private_data_length >
-            offset + 1 + adaptation_field_.length) {
-            return false;
-        }
+    // Adaptation field extension
+    if (adaptation_field_.adaptation_extension_flag) {
+        return parseAdaptationExtension(field, static_cast<size_t>(field_end - field));
+    }
+
+    return true;
+}
+
+bool TSPacket::parseAdaptationExtension(const uint8_t* data, size_t available) {
+    if (available < 1) {
+        return false;
+    }
+
+    adaptation_field_.extension_length = data[0];
+    if (adaptation_field_.extension_length == 0) {
+        return true; // Extension without flags
+    }
+    if (1 + static_cast<size_t>(adaptation_field_.extension_length) > available) {
+        return false;
+    }
+
+    const uint8_t* field = data + 1;
+    const uint8_t flags = *field++;
+    adaptation_field_.ltw_flag = (flags >> 7) & 0x01;
+    adaptation_field_.piecewise_rate_flag = (flags >> 6) & 0x01;
+    adaptation_field_.seamless_splice_flag = (flags >> 5) & 0x01;
+
+    const size_t fixed_size = 2 * adaptation_field_.ltw_flag +
+                              3 * adaptation_field_.piecewise_rate_flag +
+                              5 * adaptation_field_.seamless_splice_flag;
+    if (1 + fixed_size > adaptation_field_.extension_length) {
+        return false;
+    }
+
+    // Legal time window: ltw_valid_flag (1) | ltw_offset (15)
+    if (adaptation_field_.ltw_flag) {
+        adaptation_field_.ltw_valid = (field[0] >> 7) & 0x01;
+        adaptation_field_.ltw_offset = static_cast<uint16_t>(((field[0] & 0x7F) << 8) | field[1]);
+        field += 2;
+    }
+
+    // Piecewise rate: reserved (2) | piecewise_rate (22)
+    if (adaptation_field_.piecewise_rate_flag) {
+        adaptation_field_.piecewise_rate = (static_cast<uint32_t>(field[0] & 0x3F) << 16) |
+                                           (static_cast<uint32_t>(field[1]) << 8) |
+                                           static_cast<uint32_t>(field[2]);
+        field += 3;
+    }
 
-        adaptation_field_.private_data = &data[field_offset];
-        field_offset += adaptation_field_.private_data_length;
+    // Seamless splice: splice_type (4) | DTS_next_AU with marker bits
+    if (adaptation_field_.seamless_splice_flag) {
+        adaptation_field_.splice_type = (field[0] >> 4) & 0x0F;
+        adaptation_field_.dts_next_au = readTimestamp(field);
     }
 
     return true;
@@ -1,4 +1,5 @@
 #include "mpegts_pcr.hpp"
+#include "mpegts_types.hpp"
 #include <algorithm>
 #include <cmath>
 
@@ -9,7 +10,7 @@ namespace mpegts {
 // ============================================================================
 
 std::optional<PCR> extractPCR(const uint8_t* adaptation_field, size_t length) {
-    if (!adaptation_field || length < 6) {
+    if (!adaptation_field || length < 7) {
         return std::nullopt;
     }
 
@@ -22,27 +23,8 @@ std::optional<PCR> extractPCR(const uint8_t* adaptation_field, size_t length) {
     }
 
     // PCR starts at byte 1 of adaptation field (after flags)
-    // PCR format (6 bytes total):
-    // - 33 bits: PCR_base
-    // - 6 bits: reserved
-    // - 9 bits: PCR_extension
-
-    const uint8_t* pcr_bytes = adaptation_field + 1;
-
-    // Extract PCR_base (33 bits from first 4 bytes + 1 bit from 5th byte)
-    uint64_t pcr_base = 0;
-    pcr_base |= static_cast<uint64_t>(pcr_bytes[0]) << 25;
-    pcr_base |= static_cast<uint64_t>(pcr_bytes[1]) << 17;
-    pcr_base |= static_cast<uint64_t>(pcr_bytes[2]) << 9;
-    pcr_base |= static_cast<uint64_t>(pcr_bytes[3]) << 1;
-    pcr_base |= static_cast<uint64_t>(pcr_bytes[4] >> 7) & 0x01;
-
-    // Extract PCR_extension (9 bits from bytes 4-5)
-    uint16_t pcr_ext = 0;
-    pcr_ext |= static_cast<uint16_t>(pcr_bytes[4] & 0x01) << 8;
-    pcr_ext |= static_cast<uint16_t>(pcr_bytes[5]);
-
-    PCR pcr(pcr_base, pcr_ext);
+    PCR pcr;
+    readClockReference(adaptation_field + 1, pcr.base, pcr.extension);
 
     // Validate
     if (!pcr.isValid()) {
@@ -1,4 +1,5 @@
 #include "mpegts_pes.hpp"
+#include "mpegts_types.hpp"
 #include <cstring>
 #include <algorithm>
 
@@ -43,16 +44,7 @@ std::optional<Timestamp> PESParser::extractTimestamp(const uint8_t* data) {
     // PTS/DTS format (5 bytes):
     // '0010' or '0011' (4 bits) | PTS[32..30] | marker_bit | PTS[29..15] | marker_bit | PTS[14..0] | marker_bit
 
-    uint64_t ts = 0;
-
-    // Extract bits from 5-byte timestamp
-    ts |= (static_cast<uint64_t>(data[0] & 0x0E) >> 1) << 30;  // PTS[32:30]
-    ts |= static_cast<uint64_t>(data[1]) << 22;                // PTS[29:22]
-    ts |= (static_cast<uint64_t>(data[2] & 0xFE) >> 1) << 15;  // PTS[21:15]
-    ts |= static_cast<uint64_t>(data[3]) << 7;                 // PTS[14:7]
-    ts |= (static_cast<uint64_t>(data[4] & 0xFE) >> 1);        // PTS[6:0]
-
-    return Timestamp(ts);
+    return Timestamp(readTimestamp(data));
 }
 
 bool PESParser::parseHeader(const uint8_t* data, size_t length, PESHeader& header) {
@@ -0,0 +1,49 @@
+#ifndef MPEGTS_SIMD_HPP
+#define MPEGTS_SIMD_HPP
+
+// Internal helpers shared by the SIMD kernel translation units
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MPEGTS_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MPEGTS_TARGET(arch) __attribute__((target(arch)))
+#else
+#define MPEGTS_TARGET(arch)
+#endif
+
+namespace mpegts {
+namespace detail {
+
+/**
+ * @brief Index of the lowest set bit (mask must be non-zero)
+ */
+inline size_t countTrailingZeros(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<uint32_t>(mask))) {
+        return index;
+    }
+    _BitScanForward(&index, static_cast<uint32_t>(mask >> 32));
+    return 32 + index;
+#else
+    return static_cast<size_t>(__builtin_ctzll(mask));
+#endif
+}
+
+} // namespace detail
+} // namespace mpegts
+
+#endif // MPEGTS_SIMD_HPP
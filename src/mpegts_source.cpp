@@ -0,0 +1,202 @@
+#include "mpegts_source.hpp"
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mpegts {
+
+namespace {
+
+// Consumed bytes accumulated before pages are returned to the OS
+constexpr size_t RELEASE_GRANULARITY = 4 * 1024 * 1024;
+
+} // namespace
+
+MappedSource::MappedSource()
+    : data_(nullptr)
+    , size_(0)
+    , position_(0)
+    , released_(0)
+    , is_open_(false)
+#ifdef _WIN32
+    , file_handle_(INVALID_HANDLE_VALUE)
+    , mapping_handle_(nullptr)
+#endif
+{
+}
+
+MappedSource::~MappedSource() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedSource::open(const std::string& path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle_ = file;
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    is_open_ = true;
+
+    if (size_ == 0) {
+        return true; // Nothing to map
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        return false;
+    }
+    mapping_handle_ = mapping;
+
+    data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedSource::close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_handle_) {
+        CloseHandle(mapping_handle_);
+    }
+    if (file_handle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_handle_);
+    }
+
+    data_ = nullptr;
+    mapping_handle_ = nullptr;
+    file_handle_ = INVALID_HANDLE_VALUE;
+    size_ = 0;
+    position_ = 0;
+    released_ = 0;
+    is_open_ = false;
+}
+
+void MappedSource::releaseConsumed() {
+    // Views are paged out by the working set manager; the sequential scan
+    // hint given at open already keeps the cache footprint low
+}
+
+#else
+
+bool MappedSource::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    is_open_ = true;
+
+    if (size_ == 0) {
+        ::close(fd);
+        return true; // Nothing to map
+    }
+
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file referenced
+
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    // Aggressive read-ahead; pages behind the cursor are dropped manually
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const uint8_t*>(mapping);
+    return true;
+}
+
+void MappedSource::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+
+    data_ = nullptr;
+    size_ = 0;
+    position_ = 0;
+    released_ = 0;
+    is_open_ = false;
+}
+
+void MappedSource::releaseConsumed() {
+    if (!data_) {
+        return;
+    }
+
+    // Only whole pages strictly behind the cursor can be released
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t boundary = (position_ / page_size) * page_size;
+
+    if (boundary <= released_) {
+        return;
+    }
+
+    if (boundary - released_ >= RELEASE_GRANULARITY || atEnd()) {
+        madvise(const_cast<uint8_t*>(data_) + released_, boundary - released_, MADV_DONTNEED);
+        released_ = boundary;
+    }
+}
+
+#endif
+
+size_t MappedSource::nextWindow(const uint8_t*& window, size_t max_bytes,
+                                size_t alignment) const {
+    window = data_ + position_;
+
+    const size_t remaining = size_ - position_;
+    if (remaining <= max_bytes) {
+        return remaining;
+    }
+
+    // Round down to whole units, but never below one unit
+    if (alignment > 0 && max_bytes >= alignment) {
+        return max_bytes - (max_bytes % alignment);
+    }
+
+    return max_bytes;
+}
+
+void MappedSource::advance(size_t bytes) {
+    position_ = std::min(position_ + bytes, size_);
+    releaseConsumed();
+}
+
+} // namespace mpegts
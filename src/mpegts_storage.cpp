@@ -3,31 +3,76 @@
 
 namespace mpegts {
 
+namespace {
+
+// Timestamps are 33-bit 90 kHz counters
+constexpr uint64_t TIMESTAMP_MASK = (uint64_t(1) << 33) - 1;
+
+// A timestamp this far behind the newest one is a clock jump (PCR
+// discontinuity, splice), not presentation reordering
+constexpr int64_t CLOCK_JUMP_THRESHOLD = 10 * 90000;
+
+// Signed distance from `from` to `to` on the wrapping 33-bit clock:
+// differences of 2^32 or more are negative
+int64_t timestampDistance(uint64_t to, uint64_t from) {
+    const uint64_t difference = (to - from) & TIMESTAMP_MASK;
+    return (difference >= (uint64_t(1) << 32))
+        ? static_cast<int64_t>(difference) - static_cast<int64_t>(TIMESTAMP_MASK + 1)
+        : static_cast<int64_t>(difference);
+}
+
+// Stale arrival order entries tolerated before the queue is compacted
+constexpr size_t ARRIVAL_ORDER_SLACK = 64;
+
+} // namespace
+
 // ============================================================================
 // StreamIterations Implementation
 // ============================================================================
 
-StreamIterations::StreamIterations(uint16_t pid)
+StreamIterations::StreamIterations(uint16_t pid, StorageUsage* usage)
     : pid_(pid)
+    , usage_(usage)
+    , payload_bytes_(0)
+    , has_timestamp_(false)
+    , last_timestamp_(0)
+    , newest_timestamp_(0)
 {
 }
 
-void StreamIterations::addIteration(uint32_t iter_id, const IterationData& data) {
-    // Make a copy of iteration data
-    IterationData iter_copy = data;
-
-    // Fix payload segment pointers to point to the copied data
-    for (auto& segment : iter_copy.payloads) {
-        if (segment.offset_in_stream < iter_copy.payload_data.size()) {
-            segment.data = &iter_copy.payload_data[segment.offset_in_stream];
+void StreamIterations::addIteration(uint32_t iter_id, IterationData&& data) {
+    // Untimed iterations inherit the time of the previous one
+    if (data.has_timestamp) {
+        // The age reference only moves forward, so PTS reordered by
+        // B-frames does not age the iterations before it; a large step
+        // back is a clock jump and restarts the reference
+        if (!has_timestamp_) {
+            newest_timestamp_ = data.timestamp;
+        } else {
+            int64_t step = timestampDistance(data.timestamp, newest_timestamp_);
+            if (step > 0 || step < -CLOCK_JUMP_THRESHOLD) {
+                newest_timestamp_ = data.timestamp;
+            }
         }
+
+        has_timestamp_ = true;
+        last_timestamp_ = data.timestamp;
+    } else if (has_timestamp_) {
+        data.has_timestamp = true;
+        data.timestamp = last_timestamp_;
     }
 
-    iterations_.emplace_back(iter_id, std::move(iter_copy));
+    payload_bytes_ += data.payload_size;
+    if (usage_) {
+        usage_->iterations++;
+        usage_->bytes += data.payload_size;
+    }
 
     // Track observed CC values
     observed_cc_values_.insert(data.first_cc);
     observed_cc_values_.insert(data.last_cc);
+
+    iterations_.emplace_back(iter_id, std::move(data));
 }
 
 const IterationData* StreamIterations::getIteration(uint32_t iter_id) const {
@@ -42,15 +87,69 @@ void StreamIterations::removeIteration(uint32_t iter_id) {
         [iter_id](const auto& pair) { return pair.first == iter_id; });
 
     if (it != iterations_.end()) {
+        release(it->second);
         iterations_.erase(it);
     }
 }
 
+bool StreamIterations::evictOldest() {
+    if (iterations_.empty()) {
+        return false;
+    }
+
+    release(iterations_.front().second);
+    iterations_.pop_front();
+    return true;
+}
+
+size_t StreamIterations::enforceRetention(const RetentionPolicy& policy) {
+    size_t evicted = 0;
+
+    while (!iterations_.empty()) {
+        const IterationData& oldest = iterations_.front().second;
+
+        bool over = (policy.max_iterations > 0 && iterations_.size() > policy.max_iterations) ||
+                    (policy.max_bytes > 0 && payload_bytes_ > policy.max_bytes);
+
+        // Iterations from before the first timestamp have no age; they
+        // are older than any timed one and go first. So do iterations
+        // far ahead of the reference: they predate a backward clock jump
+        if (!over && policy.max_age > 0 && has_timestamp_) {
+            if (!oldest.has_timestamp) {
+                over = true;
+            } else {
+                int64_t age = timestampDistance(newest_timestamp_, oldest.timestamp);
+                over = age > static_cast<int64_t>(policy.max_age) || age < -CLOCK_JUMP_THRESHOLD;
+            }
+        }
+
+        if (!over) {
+            break;
+        }
+
+        evictOldest();
+        evicted++;
+    }
+
+    return evicted;
+}
+
 void StreamIterations::clear() {
+    for (const auto& [iter_id, data] : iterations_) {
+        release(data);
+    }
     iterations_.clear();
     observed_cc_values_.clear();
 }
 
+void StreamIterations::release(const IterationData& data) {
+    payload_bytes_ -= data.payload_size;
+    if (usage_) {
+        usage_->iterations--;
+        usage_->bytes -= data.payload_size;
+    }
+}
+
 bool StreamIterations::hasDiscontinuity() const {
     for (const auto& [iter_id, data] : iterations_) {
         if (data.discontinuity_detected) {
@@ -65,23 +164,122 @@ bool StreamIterations::hasDiscontinuity() const {
 // ============================================================================
 
 DemuxerStreamStorage::DemuxerStreamStorage()
-    : next_iteration_id_(1)
+    : arena_page_size_(PayloadArena::DEFAULT_PAGE_SIZE)
+    , next_iteration_id_(1)
 {
 }
 
 StreamIterations& DemuxerStreamStorage::getOrCreateStream(uint16_t pid) {
     auto it = streams_.find(pid);
     if (it == streams_.end()) {
-        it = streams_.emplace(pid, StreamIterations(pid)).first;
+        it = streams_.emplace(pid, StreamIterations(pid, &usage_)).first;
+
+        auto policy = stream_policies_.find(pid);
+        if (policy != stream_policies_.end()) {
+            it->second.setRetentionPolicy(policy->second);
+        }
     }
     return it->second;
 }
 
+PayloadArena& DemuxerStreamStorage::getArena(uint16_t pid) {
+    auto& arena = arenas_[pid];
+    if (!arena) {
+        arena = std::make_unique<PayloadArena>(arena_page_size_);
+    }
+    return *arena;
+}
+
 const StreamIterations* DemuxerStreamStorage::getStream(uint16_t pid) const {
     auto it = streams_.find(pid);
     return (it != streams_.end()) ? &it->second : nullptr;
 }
 
+void DemuxerStreamStorage::addIteration(uint16_t pid, uint32_t iter_id,
+                                        IterationData&& data) {
+    auto& stream = getOrCreateStream(pid);
+    stream.addIteration(iter_id, std::move(data));
+    arrival_order_.emplace_back(pid, iter_id);
+
+    stream.enforceRetention(stream.getRetentionPolicy());
+    if (policy_.max_age > 0) {
+        RetentionPolicy age_limit;
+        age_limit.max_age = policy_.max_age;
+        stream.enforceRetention(age_limit);
+    }
+
+    enforceGlobalRetention();
+}
+
+void DemuxerStreamStorage::setRetentionPolicy(const RetentionPolicy& policy) {
+    policy_ = policy;
+
+    if (policy_.max_age > 0) {
+        RetentionPolicy age_limit;
+        age_limit.max_age = policy_.max_age;
+        for (auto& [pid, stream] : streams_) {
+            stream.enforceRetention(age_limit);
+        }
+    }
+
+    enforceGlobalRetention();
+}
+
+void DemuxerStreamStorage::setRetentionPolicy(uint16_t pid, const RetentionPolicy& policy) {
+    stream_policies_[pid] = policy;
+
+    auto it = streams_.find(pid);
+    if (it != streams_.end()) {
+        it->second.setRetentionPolicy(policy);
+        it->second.enforceRetention(policy);
+        enforceGlobalRetention();
+    }
+}
+
+void DemuxerStreamStorage::enforceGlobalRetention() {
+    // The front entry is either the oldest iteration of its stream, or
+    // stale (iteration already removed): each entry is visited once
+    while ((policy_.max_iterations > 0 && usage_.iterations > policy_.max_iterations) ||
+           (policy_.max_bytes > 0 && usage_.bytes > policy_.max_bytes)) {
+        if (arrival_order_.empty()) {
+            break;
+        }
+
+        auto [pid, iter_id] = arrival_order_.front();
+        arrival_order_.pop_front();
+
+        auto it = streams_.find(pid);
+        if (it != streams_.end() && !it->second.getIterations().empty() &&
+            it->second.getIterations().front().first == iter_id) {
+            it->second.evictOldest();
+        }
+    }
+
+    // Drop stale entries once they outnumber the stored iterations. Live
+    // entries of a stream appear in the same order as its iterations, so
+    // one pass with a cursor per stream finds them
+    if (arrival_order_.size() > 2 * usage_.iterations + ARRIVAL_ORDER_SLACK) {
+        std::map<uint16_t, size_t> cursors;
+        std::deque<std::pair<uint16_t, uint32_t>> live;
+
+        for (const auto& entry : arrival_order_) {
+            auto it = streams_.find(entry.first);
+            if (it == streams_.end()) {
+                continue;
+            }
+
+            const auto& iterations = it->second.getIterations();
+            size_t& cursor = cursors[entry.first];
+            if (cursor < iterations.size() && iterations[cursor].first == entry.second) {
+                live.push_back(entry);
+                cursor++;
+            }
+        }
+
+        arrival_order_.swap(live);
+    }
+}
+
 uint32_t DemuxerStreamStorage::generateIterationID() {
     return next_iteration_id_++;
 }
@@ -95,6 +293,9 @@ void DemuxerStreamStorage::clearStream(uint16_t pid) {
 
 void DemuxerStreamStorage::clear() {
     streams_.clear();
+    arenas_.clear();
+    arrival_order_.clear();
+    usage_ = StorageUsage();
     next_iteration_id_ = 1;
 }
 
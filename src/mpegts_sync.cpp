@@ -0,0 +1,338 @@
+#include "mpegts_sync.hpp"
+#include "mpegts_simd.hpp"
+
+namespace mpegts {
+
+namespace {
+
+// Grid slots scored per stride during format detection
+constexpr size_t FORMAT_SCORE_PACKETS = 16;
+
+// Null packet test on the first header bytes read as a little-endian word:
+// sync byte, PID[12:8] and PID[7:0] (TEI, PUSI, priority and byte 3 ignored)
+constexpr uint32_t NULL_HEADER_MASK = 0x00FF1FFF;
+constexpr uint32_t NULL_HEADER_VALUE = 0x00FF1F47;
+
+using detail::countTrailingZeros;
+
+// ============================================================================
+// Kernels
+//
+// Each kernel scans positions [0, limit) where limit = length - 2 * stride,
+// comparing the bytes at p, p + stride and p + 2 * stride against the sync
+// byte for a whole vector of positions at once. The combined mask filters
+// candidates before any header is parsed. Returns limit if none found.
+// ============================================================================
+
+size_t scanScalar(const uint8_t* data, size_t limit, size_t stride) {
+    for (size_t pos = 0; pos < limit; ++pos) {
+        if (data[pos] == MPEGTS_SYNC_BYTE &&
+            data[pos + stride] == MPEGTS_SYNC_BYTE &&
+            data[pos + 2 * stride] == MPEGTS_SYNC_BYTE) {
+            return pos;
+        }
+    }
+    return limit;
+}
+
+// Null packet run kernels: test the header word of count packets spaced
+// stride apart, return the index of the first non-null packet (or count)
+
+size_t nullRunScalar(const uint8_t* data, size_t count, size_t stride) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* packet = data + i * stride;
+        uint32_t word = uint32_t(packet[0]) | (uint32_t(packet[1]) << 8) |
+                        (uint32_t(packet[2]) << 16);
+        if ((word & NULL_HEADER_MASK) != NULL_HEADER_VALUE) {
+            return i;
+        }
+    }
+    return count;
+}
+
+#if defined(MPEGTS_SIMD_X86)
+
+MPEGTS_TARGET("sse2")
+size_t scanSSE2(const uint8_t* data, size_t limit, size_t stride) {
+    const __m128i sync = _mm_set1_epi8(static_cast<char>(MPEGTS_SYNC_BYTE));
+
+    size_t pos = 0;
+    for (; pos + 16 <= limit; pos += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + stride));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 2 * stride));
+
+        __m128i hits = _mm_and_si128(_mm_cmpeq_epi8(a, sync),
+                       _mm_and_si128(_mm_cmpeq_epi8(b, sync),
+                                     _mm_cmpeq_epi8(c, sync)));
+
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return pos + countTrailingZeros(mask);
+        }
+    }
+
+    return pos + scanScalar(data + pos, limit - pos, stride);
+}
+
+MPEGTS_TARGET("avx2")
+size_t scanAVX2(const uint8_t* data, size_t limit, size_t stride) {
+    const __m256i sync = _mm256_set1_epi8(static_cast<char>(MPEGTS_SYNC_BYTE));
+
+    size_t pos = 0;
+    for (; pos + 32 <= limit; pos += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + stride));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 2 * stride));
+
+        __m256i hits = _mm256_and_si256(_mm256_cmpeq_epi8(a, sync),
+                       _mm256_and_si256(_mm256_cmpeq_epi8(b, sync),
+                                        _mm256_cmpeq_epi8(c, sync)));
+
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            return pos + countTrailingZeros(mask);
+        }
+    }
+
+    return pos + scanSSE2(data + pos, limit - pos, stride);
+}
+
+MPEGTS_TARGET("avx512f,avx512bw")
+size_t scanAVX512(const uint8_t* data, size_t limit, size_t stride) {
+    const __m512i sync = _mm512_set1_epi8(static_cast<char>(MPEGTS_SYNC_BYTE));
+
+    size_t pos = 0;
+    for (; pos + 64 <= limit; pos += 64) {
+        __m512i a = _mm512_loadu_si512(data + pos);
+        __m512i b = _mm512_loadu_si512(data + pos + stride);
+        __m512i c = _mm512_loadu_si512(data + pos + 2 * stride);
+
+        uint64_t mask = _mm512_cmpeq_epi8_mask(a, sync) &
+                        _mm512_cmpeq_epi8_mask(b, sync) &
+                        _mm512_cmpeq_epi8_mask(c, sync);
+        if (mask != 0) {
+            return pos + countTrailingZeros(mask);
+        }
+    }
+
+    return pos + scanAVX2(data + pos, limit - pos, stride);
+}
+
+MPEGTS_TARGET("avx2")
+size_t nullRunAVX2(const uint8_t* data, size_t count, size_t stride) {
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                               _mm256_set1_epi32(static_cast<int>(stride)));
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(NULL_HEADER_MASK));
+    const __m256i value = _mm256_set1_epi32(static_cast<int>(NULL_HEADER_VALUE));
+
+    // Eight header words per step, gathered across packets
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int* base = reinterpret_cast<const int*>(data + i * stride);
+        __m256i words = _mm256_i32gather_epi32(base, offsets, 1);
+        __m256i hits = _mm256_cmpeq_epi32(_mm256_and_si256(words, mask), value);
+
+        uint32_t null_mask = static_cast<uint32_t>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(hits)));
+        if (null_mask != 0xFF) {
+            return i + countTrailingZeros(~null_mask);
+        }
+    }
+
+    return i + nullRunScalar(data + i * stride, count - i, stride);
+}
+
+MPEGTS_TARGET("avx512f,avx512bw")
+size_t nullRunAVX512(const uint8_t* data, size_t count, size_t stride) {
+    const __m512i offsets = _mm512_mullo_epi32(
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm512_set1_epi32(static_cast<int>(stride)));
+    const __m512i mask = _mm512_set1_epi32(static_cast<int>(NULL_HEADER_MASK));
+    const __m512i value = _mm512_set1_epi32(static_cast<int>(NULL_HEADER_VALUE));
+
+    // Sixteen header words per step
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        // Masked form with a zero source: the plain gather leaves its
+        // destination formally uninitialized (-Wmaybe-uninitialized)
+        __m512i words = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, offsets,
+                                                    data + i * stride, 1);
+        uint32_t null_mask = _mm512_cmpeq_epi32_mask(_mm512_and_si512(words, mask), value);
+        if (null_mask != 0xFFFF) {
+            return i + countTrailingZeros(~null_mask);
+        }
+    }
+
+    return i + nullRunAVX2(data + i * stride, count - i, stride);
+}
+
+// ============================================================================
+// CPU Feature Detection
+// ============================================================================
+
+SyncScanKernel detectKernelFromCPU() {
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    const int max_leaf = regs[0];
+
+    __cpuid(regs, 1);
+    const bool sse2 = (regs[3] & (1 << 26)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+
+    bool avx2 = false;
+    bool avx512 = false;
+    if (osxsave && max_leaf >= 7) {
+        const unsigned long long xcr0 = _xgetbv(0);
+        const bool ymm_state = (xcr0 & 0x06) == 0x06;
+        const bool zmm_state = (xcr0 & 0xE6) == 0xE6;
+
+        __cpuidex(regs, 7, 0);
+        avx2 = ymm_state && (regs[1] & (1 << 5)) != 0;
+        avx512 = zmm_state && (regs[1] & (1 << 16)) != 0 &&     // AVX-512F
+                 (regs[1] & (1 << 30)) != 0;                    // AVX-512BW
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse2 = __builtin_cpu_supports("sse2");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+    const bool avx512 = __builtin_cpu_supports("avx512f") &&
+                        __builtin_cpu_supports("avx512bw");
+#endif
+
+    if (avx512) {
+        return SyncScanKernel::AVX512;
+    }
+    if (avx2) {
+        return SyncScanKernel::AVX2;
+    }
+    if (sse2) {
+        return SyncScanKernel::SSE2;
+    }
+    return SyncScanKernel::SCALAR;
+}
+
+#else // !MPEGTS_SIMD_X86
+
+SyncScanKernel detectKernelFromCPU() {
+    return SyncScanKernel::SCALAR;
+}
+
+#endif // MPEGTS_SIMD_X86
+
+} // namespace
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+SyncScanKernel detectSyncScanKernel() {
+    static const SyncScanKernel kernel = detectKernelFromCPU();
+    return kernel;
+}
+
+bool isSyncScanKernelSupported(SyncScanKernel kernel) {
+    return static_cast<uint8_t>(kernel) <= static_cast<uint8_t>(detectSyncScanKernel());
+}
+
+const char* getSyncScanKernelName(SyncScanKernel kernel) {
+    switch (kernel) {
+        case SyncScanKernel::SCALAR: return "Scalar";
+        case SyncScanKernel::SSE2: return "SSE2";
+        case SyncScanKernel::AVX2: return "AVX2";
+        case SyncScanKernel::AVX512: return "AVX-512";
+        default: return "Unknown";
+    }
+}
+
+size_t findSyncCandidate(const uint8_t* data, size_t length, size_t stride) {
+    return findSyncCandidate(detectSyncScanKernel(), data, length, stride);
+}
+
+size_t findSyncCandidate(SyncScanKernel kernel, const uint8_t* data,
+                         size_t length, size_t stride) {
+    if (!data || stride == 0 || length <= 2 * stride) {
+        return length;
+    }
+
+    const size_t limit = length - 2 * stride;
+    size_t pos = limit;
+
+    switch (kernel) {
+#if defined(MPEGTS_SIMD_X86)
+        case SyncScanKernel::AVX512:
+            pos = scanAVX512(data, limit, stride);
+            break;
+        case SyncScanKernel::AVX2:
+            pos = scanAVX2(data, limit, stride);
+            break;
+        case SyncScanKernel::SSE2:
+            pos = scanSSE2(data, limit, stride);
+            break;
+#endif
+        default:
+            pos = scanScalar(data, limit, stride);
+            break;
+    }
+
+    return (pos < limit) ? pos : length;
+}
+
+size_t countNullPacketRun(const uint8_t* data, size_t count, size_t stride) {
+    return countNullPacketRun(detectSyncScanKernel(), data, count, stride);
+}
+
+size_t countNullPacketRun(SyncScanKernel kernel, const uint8_t* data,
+                          size_t count, size_t stride) {
+    if (!data || count == 0) {
+        return 0;
+    }
+
+    switch (kernel) {
+#if defined(MPEGTS_SIMD_X86)
+        case SyncScanKernel::AVX512:
+            return nullRunAVX512(data, count, stride);
+        case SyncScanKernel::AVX2:
+            return nullRunAVX2(data, count, stride);
+#endif
+        default:
+            // SSE2 has no gather: the scalar word test is as fast
+            return nullRunScalar(data, count, stride);
+    }
+}
+
+PacketFormat detectPacketFormat(const uint8_t* data, size_t length) {
+    const PacketFormat formats[] = {
+        PacketFormat::TS, PacketFormat::M2TS, PacketFormat::TS_RS
+    };
+
+    PacketFormat best_format = PacketFormat::AUTO;
+    size_t best_score = 0;
+
+    for (PacketFormat format : formats) {
+        const size_t stride = getPacketStride(format);
+
+        size_t pos = findSyncCandidate(data, length, stride);
+        if (pos == length) {
+            continue;
+        }
+
+        size_t score = 0;
+        for (size_t slot = 0; slot < FORMAT_SCORE_PACKETS && pos < length; ++slot) {
+            if (data[pos] == MPEGTS_SYNC_BYTE) {
+                score++;
+            }
+            pos += stride;
+        }
+
+        if (score > best_score) {
+            best_format = format;
+            best_score = score;
+        }
+    }
+
+    return best_format;
+}
+
+} // namespace mpegts
@@ -0,0 +1,385 @@
+#include "test_framework.hpp"
+#include "test_packet_generator.hpp"
+#include "mpegts_batch.hpp"
+#include "mpegts_demuxer.hpp"
+#include "mpegts_packet.hpp"
+#include <map>
+
+using namespace mpegts;
+using namespace test;
+
+static const SyncScanKernel KERNELS[] = {
+    SyncScanKernel::SCALAR, SyncScanKernel::SSE2,
+    SyncScanKernel::AVX2, SyncScanKernel::AVX512
+};
+
+// Random header bytes behind a sync byte (adaptation control never reserved)
+static std::vector<uint8_t> randomPackets(PacketGenerator& gen, size_t count, size_t stride) {
+    auto data = gen.generateGarbage(count * stride, true);
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t* packet = &data[i * stride];
+        packet[0] = (i % 7 == 3) ? 0x00 : MPEGTS_SYNC_BYTE; // Some sync misses
+        if ((packet[3] & 0x30) == 0) {
+            packet[3] |= 0x10;
+        }
+    }
+    return data;
+}
+
+// ============================================================================
+// Batch Header Decoder Tests
+// ============================================================================
+
+TEST(batch_matches_packet_parser) {
+    PacketGenerator gen;
+    gen.setSeed(1234);
+
+    auto data = randomPackets(gen, HEADER_BATCH_SIZE, MPEGTS_PACKET_SIZE);
+
+    PacketHeaderBatch batch;
+    TEST_ASSERT_EQ(decodeHeaders(data.data(), HEADER_BATCH_SIZE, batch), HEADER_BATCH_SIZE,
+                  "Should decode a full batch");
+
+    for (size_t i = 0; i < HEADER_BATCH_SIZE; ++i) {
+        const uint8_t* packet = &data[i * MPEGTS_PACKET_SIZE];
+        const uint32_t bit = uint32_t(1) << i;
+
+        TEST_ASSERT_EQ((batch.sync_mask & bit) != 0, packet[0] == MPEGTS_SYNC_BYTE,
+                      "Sync flag should match");
+
+        TSPacket parsed;
+        if (!parsed.parse(packet)) {
+            continue;
+        }
+        const auto& header = parsed.getHeader();
+
+        TEST_ASSERT_EQ(batch.pid[i], header.pid, "PID should match");
+        TEST_ASSERT_EQ(batch.continuity_counter[i], header.continuity_counter, "CC should match");
+        TEST_ASSERT_EQ(batch.adaptation_control[i],
+                      static_cast<uint8_t>(header.adaptation_control), "AFC should match");
+        TEST_ASSERT_EQ(batch.scrambling_control[i], header.scrambling_control,
+                      "Scrambling should match");
+        TEST_ASSERT_EQ((batch.tei_mask & bit) != 0, header.transport_error_indicator,
+                      "TEI should match");
+        TEST_ASSERT_EQ((batch.pusi_mask & bit) != 0, header.payload_unit_start,
+                      "PUSI should match");
+        TEST_ASSERT_EQ((batch.priority_mask & bit) != 0, header.transport_priority,
+                      "Priority should match");
+    }
+
+    return true;
+}
+
+TEST(batch_kernels_agree) {
+    PacketGenerator gen;
+    gen.setSeed(99);
+
+    const size_t strides[] = {MPEGTS_PACKET_SIZE, M2TS_PACKET_SIZE, RS_PACKET_SIZE};
+
+    for (size_t stride : strides) {
+        for (size_t count = 1; count <= HEADER_BATCH_SIZE + 3; ++count) {
+            auto data = randomPackets(gen, count, stride);
+
+            PacketHeaderBatch expected;
+            decodeHeaders(SyncScanKernel::SCALAR, data.data(), count, expected, stride);
+
+            for (SyncScanKernel kernel : KERNELS) {
+                if (!isSyncScanKernelSupported(kernel)) {
+                    continue;
+                }
+
+                PacketHeaderBatch batch;
+                size_t decoded = decodeHeaders(kernel, data.data(), count, batch, stride);
+                TEST_ASSERT_EQ(decoded, expected.count, "Count should match");
+                TEST_ASSERT_EQ(batch.sync_mask, expected.sync_mask, "Sync mask should match");
+                TEST_ASSERT_EQ(batch.tei_mask, expected.tei_mask, "TEI mask should match");
+                TEST_ASSERT_EQ(batch.pusi_mask, expected.pusi_mask, "PUSI mask should match");
+                TEST_ASSERT_EQ(batch.priority_mask, expected.priority_mask,
+                              "Priority mask should match");
+
+                for (size_t i = 0; i < decoded; ++i) {
+                    TEST_ASSERT_EQ(batch.pid[i], expected.pid[i], "PID should match");
+                    TEST_ASSERT_EQ(batch.continuity_counter[i], expected.continuity_counter[i],
+                                  "CC should match");
+                    TEST_ASSERT_EQ(batch.adaptation_control[i], expected.adaptation_control[i],
+                                  "AFC should match");
+                    TEST_ASSERT_EQ(batch.scrambling_control[i], expected.scrambling_control[i],
+                                  "Scrambling should match");
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// ============================================================================
+// Batch Continuity Check Tests
+// ============================================================================
+
+struct CCPacket {
+    uint16_t pid;
+    uint8_t cc;
+    uint8_t afc;
+};
+
+static void fillBatch(PacketHeaderBatch& batch, const CCPacket* packets, size_t count) {
+    batch.count = count;
+    for (size_t i = 0; i < count; ++i) {
+        batch.pid[i] = packets[i].pid;
+        batch.continuity_counter[i] = packets[i].cc;
+        batch.adaptation_control[i] = packets[i].afc;
+    }
+}
+
+TEST(continuity_verdicts) {
+    // 0x100: in order, adaptation-only, duplicate, jump, signalled jump
+    // 0x200: interleaved, in order after its first packet, then sent
+    // three times (the third copy is an error)
+    const CCPacket packets[] = {
+        {0x100, 0, 1}, {0x200, 9, 1}, {0x100, 1, 3}, {0x100, 1, 2},
+        {0x100, 2, 1}, {0x200, 10, 1}, {0x100, 2, 1}, {0x100, 7, 1},
+        {0x100, 3, 1}, {0x200, 11, 3}, {0x200, 15, 1}, {0x200, 11, 1},
+        {0x200, 11, 1},
+    };
+    const size_t count = sizeof(packets) / sizeof(packets[0]);
+
+    PacketHeaderBatch batch;
+    fillBatch(batch, packets, count);
+
+    const uint32_t all = (uint32_t(1) << count) - 1;
+    const uint32_t indicator = uint32_t(1) << 8;
+    const uint32_t excluded = uint32_t(1) << 10;   // Left to the caller
+
+    for (SyncScanKernel kernel : KERNELS) {
+        if (!isSyncScanKernelSupported(kernel)) {
+            continue;
+        }
+
+        PIDStateTable states;
+        ContinuityResult result;
+        checkContinuity(kernel, batch, all & ~excluded, indicator, states, result);
+
+        TEST_ASSERT_EQ(result.duplicate_mask, (uint32_t(1) << 6) | (uint32_t(1) << 11),
+                       "Repeated CC is a duplicate");
+        TEST_ASSERT_EQ(result.error_mask, (uint32_t(1) << 7) | (uint32_t(1) << 12),
+                       "Unsignalled jump and second repeat are errors");
+        TEST_ASSERT_EQ(result.discontinuity_mask, indicator, "Signalled jump is a discontinuity");
+
+        TEST_ASSERT_EQ(states[0x100].last_cc, 3, "State should hold the last CC");
+        TEST_ASSERT_EQ(states[0x200].last_cc, 11, "Excluded packets leave the state");
+        TEST_ASSERT_TRUE(states[0x200].flags & PID_STATE_CC_VALID, "State should be valid");
+    }
+
+    return true;
+}
+
+TEST(continuity_carries_across_batches) {
+    const CCPacket first[] = {{0x100, 14, 1}, {0x100, 15, 1}};
+    const CCPacket second[] = {{0x100, 0, 1}, {0x100, 2, 1}};
+
+    PIDStateTable states;
+    PacketHeaderBatch batch;
+    ContinuityResult result;
+
+    fillBatch(batch, first, 2);
+    checkContinuity(batch, 0x3, 0, states, result);
+    TEST_ASSERT_EQ(result.error_mask, 0, "First batch should be in order");
+
+    fillBatch(batch, second, 2);
+    checkContinuity(batch, 0x3, 0, states, result);
+    TEST_ASSERT_EQ(result.error_mask, 0x2, "Counter should wrap, then jump");
+
+    return true;
+}
+
+// ============================================================================
+// Demuxer Batch Path Tests
+// ============================================================================
+
+// Mixed stream: three interleaved PIDs with PUSI, private data, null runs,
+// duplicates (some sent three times), CC jumps and TEI packets
+static std::vector<uint8_t> mixedStream(PacketGenerator& gen, size_t count) {
+    std::uniform_int_distribution<int> dist(0, 99);
+    std::mt19937 rng(4321);
+
+    std::vector<uint8_t> data;
+    std::map<uint16_t, uint8_t> next_cc;
+
+    for (size_t n = 0; n < count; ++n) {
+        const int roll = (n < 8) ? 99 : dist(rng);  // Clean start for sync
+
+        if (roll < 8) {
+            auto nulls = gen.generateSequence(1 + roll % 3, GeneratorConfig{PID_NULL});
+            data.insert(data.end(), nulls.begin(), nulls.end());
+            continue;
+        }
+
+        GeneratorConfig config;
+        config.pid = static_cast<uint16_t>(0x100 + n % 3);
+        config.starting_cc = next_cc[config.pid];
+        config.set_pusi = (n % 5 == 0);
+        config.include_adaptation = (roll % 4 == 0);
+        config.include_private_data = (roll % 8 == 0);
+        config.payload_pattern = static_cast<uint8_t>(n);
+
+        if (roll >= 8 && roll < 12) {
+            config.starting_cc = (config.starting_cc + 2) & 0x0F;   // CC jump
+        }
+
+        auto packet = gen.generatePacket(config);
+        if (roll >= 12 && roll < 15) {
+            packet[1] |= 0x80;                                      // TEI
+        }
+
+        data.insert(data.end(), packet.begin(), packet.end());
+        if (roll >= 15 && roll < 21) {
+            data.insert(data.end(), packet.begin(), packet.end());  // Duplicate
+        }
+        if (roll >= 15 && roll < 17) {
+            data.insert(data.end(), packet.begin(), packet.end());  // ... sent three times
+        }
+
+        next_cc[config.pid] = (config.starting_cc + 1) & 0x0F;
+    }
+
+    return data;
+}
+
+// Expected iteration of the packet-by-packet reference
+struct ReferenceIteration {
+    uint32_t packet_count = 0;
+    bool cc_error = false;
+    std::vector<uint8_t> normal;
+    std::vector<uint8_t> private_data;
+};
+
+// Packet-by-packet reference of the demuxer: full parse, scalar CC check
+// (one duplicate allowed), TEI packets dropped, new iteration on PUSI
+static void referenceDemux(const std::vector<uint8_t>& data, DemuxerStats& stats,
+                           std::map<uint16_t, std::vector<ReferenceIteration>>& iterations) {
+    struct CCState {
+        bool valid = false;
+        bool repeated = false;
+        uint8_t last = 0;
+    };
+    std::map<uint16_t, CCState> cc_states;
+
+    for (size_t offset = 0; offset + MPEGTS_PACKET_SIZE <= data.size();
+         offset += MPEGTS_PACKET_SIZE) {
+        TSPacket packet;
+        if (!packet.parse(&data[offset])) {
+            stats.packets_skipped++;
+            continue;
+        }
+
+        const auto& header = packet.getHeader();
+        if (header.pid == PID_NULL) {
+            stats.null_packets++;
+            continue;
+        }
+        if (header.transport_error_indicator) {
+            stats.tei_packets++;
+            continue;
+        }
+
+        CCState& cc = cc_states[header.pid];
+        const uint8_t has_payload = packet.hasPayload() ? 1 : 0;
+        const bool repeats = cc.valid && has_payload && header.continuity_counter == cc.last;
+        bool cc_error = false;
+
+        if (cc.valid && header.continuity_counter != ((cc.last + has_payload) & 0x0F)) {
+            if (repeats && !cc.repeated) {
+                stats.cc_duplicates++;
+                cc.repeated = true;
+                continue;
+            }
+            stats.cc_errors++;
+            cc_error = true;
+        }
+        cc.valid = true;
+        cc.repeated = repeats;
+        cc.last = header.continuity_counter;
+
+        auto& stream = iterations[header.pid];
+        if (stream.empty() || header.payload_unit_start) {
+            stream.emplace_back();
+        }
+
+        ReferenceIteration& iteration = stream.back();
+        iteration.packet_count++;
+        iteration.cc_error |= cc_error;
+        if (packet.getPrivateDataLength() > 0) {
+            iteration.private_data.insert(iteration.private_data.end(), packet.getPrivateData(),
+                                          packet.getPrivateData() + packet.getPrivateDataLength());
+        }
+        if (packet.hasPayload()) {
+            iteration.normal.insert(iteration.normal.end(), packet.getPayload(),
+                                    packet.getPayload() + packet.getPayloadSize());
+        }
+    }
+}
+
+TEST(demuxer_batch_path_matches_packet_reference) {
+    PacketGenerator gen;
+    gen.setSeed(99);
+
+    auto data = mixedStream(gen, 400);
+
+    DemuxerStats expected_stats;
+    std::map<uint16_t, std::vector<ReferenceIteration>> expected;
+    referenceDemux(data, expected_stats, expected);
+
+    TEST_ASSERT_TRUE(expected_stats.cc_duplicates > 0 && expected_stats.cc_errors > 0 &&
+                     expected_stats.tei_packets > 0 && expected_stats.null_packets > 0,
+                     "Stream should exercise every verdict");
+
+    // One feed (validated packets reused by the first batch pass), then
+    // chunks that split packets and batches
+    for (size_t chunk : {data.size(), size_t(1000)}) {
+        MPEGTSDemuxer demuxer;
+        for (size_t offset = 0; offset < data.size(); offset += chunk) {
+            demuxer.feedData(data.data() + offset, std::min(chunk, data.size() - offset));
+        }
+
+        const DemuxerStats& stats = demuxer.getStats();
+        TEST_ASSERT_EQ(stats.sync_acquisitions, 1u, "Should lock once");
+        TEST_ASSERT_EQ(stats.packets_skipped, expected_stats.packets_skipped, "Skipped packets");
+        TEST_ASSERT_EQ(stats.null_packets, expected_stats.null_packets, "Null packets");
+        TEST_ASSERT_EQ(stats.tei_packets, expected_stats.tei_packets, "TEI packets");
+        TEST_ASSERT_EQ(stats.cc_errors, expected_stats.cc_errors, "CC errors");
+        TEST_ASSERT_EQ(stats.cc_duplicates, expected_stats.cc_duplicates, "Duplicates");
+
+        TEST_ASSERT_EQ(demuxer.getDiscoveredPIDs().size(), expected.size(), "Stored PIDs");
+
+        for (const auto& [pid, iterations] : expected) {
+            auto summary = demuxer.getIterationsSummary(pid);
+            TEST_ASSERT_EQ(summary.size(), iterations.size(), "Iteration count");
+
+            for (size_t k = 0; k < summary.size(); ++k) {
+                const ReferenceIteration& reference = iterations[k];
+                TEST_ASSERT_EQ(summary[k].packet_count, reference.packet_count, "Packet count");
+                TEST_ASSERT_EQ(summary[k].has_cc_error, reference.cc_error, "CC error flag");
+
+                std::vector<uint8_t> normal;
+                std::vector<uint8_t> private_data;
+                for (const auto& buffer : demuxer.getAllPayloads(pid, summary[k].iteration_id)) {
+                    auto& target = (buffer.type == PayloadType::PAYLOAD_NORMAL) ? normal : private_data;
+                    target.insert(target.end(), buffer.data, buffer.data + buffer.length);
+                }
+                TEST_ASSERT_TRUE(normal == reference.normal, "Payload should match");
+                TEST_ASSERT_TRUE(private_data == reference.private_data, "Private data should match");
+            }
+        }
+    }
+
+    return true;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main() {
+    return TestRegistry::instance().runAll();
+}
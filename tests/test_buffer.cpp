@@ -0,0 +1,90 @@
+#include "test_framework.hpp"
+#include "mpegts_buffer.hpp"
+#include "mpegts_types.hpp"
+
+using namespace mpegts;
+using namespace test;
+
+// ============================================================================
+// Ingest Buffer Tests
+// ============================================================================
+
+TEST(buffer_append_and_consume) {
+    IngestBuffer buffer(16);
+
+    const uint8_t data[] = {1, 2, 3, 4, 5, 6};
+    buffer.append(data, sizeof(data));
+
+    TEST_ASSERT_EQ(buffer.size(), 6, "Should hold appended bytes");
+    TEST_ASSERT_EQ(buffer[0], 1, "First byte should be 1");
+
+    buffer.consume(4);
+    TEST_ASSERT_EQ(buffer.size(), 2, "Should hold remaining bytes");
+    TEST_ASSERT_EQ(buffer.data()[0], 5, "Front should advance after consume");
+
+    buffer.consume(10);
+    TEST_ASSERT_TRUE(buffer.empty(), "Over-consume should empty the buffer");
+
+    return true;
+}
+
+TEST(buffer_keeps_order_across_compaction) {
+    IngestBuffer buffer(8);
+
+    // Feed a running counter in odd-sized chunks while consuming most of it,
+    // forcing the write position past the storage end several times
+    uint8_t next = 0;
+    uint8_t expected = 0;
+    for (int round = 0; round < 50; ++round) {
+        uint8_t chunk[5];
+        for (auto& byte : chunk) {
+            byte = next++;
+        }
+        buffer.append(chunk, sizeof(chunk));
+
+        while (buffer.size() > 2) {
+            TEST_ASSERT_EQ(int(buffer[0]), int(expected), "Bytes should stay in order");
+            buffer.consume(1);
+            expected++;
+        }
+    }
+
+    return true;
+}
+
+TEST(buffer_overflow_drops_oldest) {
+    IngestBuffer buffer(8);
+
+    const uint8_t first[] = {1, 2, 3, 4, 5, 6};
+    const uint8_t second[] = {7, 8, 9, 10};
+    buffer.append(first, sizeof(first));
+    buffer.append(second, sizeof(second));
+
+    TEST_ASSERT_EQ(buffer.size(), 8, "Should be clamped to capacity");
+    TEST_ASSERT_EQ(int(buffer[0]), 3, "Oldest bytes should be dropped");
+    TEST_ASSERT_EQ(int(buffer[7]), 10, "Newest byte should be kept");
+    TEST_ASSERT_EQ(buffer.available(), 0, "Full buffer should have no room");
+
+    // A single append larger than capacity keeps only its tail
+    uint8_t large[20];
+    for (size_t i = 0; i < sizeof(large); ++i) {
+        large[i] = static_cast<uint8_t>(100 + i);
+    }
+    buffer.append(large, sizeof(large));
+
+    TEST_ASSERT_EQ(buffer.size(), 8, "Should be clamped to capacity");
+    TEST_ASSERT_EQ(int(buffer[0]), 112, "Should keep the newest bytes");
+
+    buffer.consume(3);
+    TEST_ASSERT_EQ(buffer.available(), 3, "Consumed bytes should free room");
+
+    return true;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main() {
+    return TestRegistry::instance().runAll();
+}
@@ -1,6 +1,8 @@
 #include "test_framework.hpp"
 #include "test_packet_generator.hpp"
 #include "mpegts_demuxer.hpp"
+#include <algorithm>
+#include <map>
 
 using namespace mpegts;
 using namespace test;
@@ -146,6 +148,43 @@ TEST(continuity_counter_tracking) {
     return true;
 }
 
+TEST(continuity_errors_counted) {
+    PacketGenerator gen;
+    MPEGTSDemuxer demuxer;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    // CC 0..4, a duplicate of 4, then a jump to 9 (packets lost)
+    auto data = gen.generateSequence(5, config);
+    data.insert(data.end(), data.end() - MPEGTS_PACKET_SIZE, data.end());
+    config.starting_cc = 9;
+    auto tail = gen.generateSequence(5, config);
+    data.insert(data.end(), tail.begin(), tail.end());
+
+    // Unit start closes the iteration
+    config.starting_cc = 14;
+    config.set_pusi = true;
+    auto closing = gen.generatePacket(config);
+    data.insert(data.end(), closing.begin(), closing.end());
+
+    demuxer.feedData(data.data(), data.size());
+
+    const auto& cc_stats = demuxer.getContinuityStats(0x100);
+    TEST_ASSERT_EQ(cc_stats.cc_errors, 1, "Jump should be counted");
+    TEST_ASSERT_EQ(cc_stats.duplicates, 1, "Duplicate should be counted");
+    TEST_ASSERT_EQ(cc_stats.discontinuities, 0, "Nothing was signalled");
+    TEST_ASSERT_EQ(demuxer.getStats().cc_errors, 1, "Total should match");
+
+    bool flagged = false;
+    for (const auto& info : demuxer.getIterationsSummary(0x100)) {
+        flagged = flagged || info.has_cc_error;
+    }
+    TEST_ASSERT_TRUE(flagged, "Iteration with the jump should be flagged");
+
+    return true;
+}
+
 TEST(system_pid_filtering) {
     PacketGenerator gen;
     MPEGTSDemuxer demuxer;
@@ -193,6 +232,356 @@ TEST(private_data_extraction) {
     return true;
 }
 
+TEST(policy_demuxer_filters_and_sinks) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+    config.include_adaptation = true;
+    config.include_private_data = true;
+
+    auto data = gen.generateSequence(4, config);
+    config.pid = 0x200;
+    auto other = gen.generateSequence(4, config);
+    data.insert(data.end(), other.begin(), other.end());
+
+    // Only 0x100 is parsed, and only its normal payload is kept
+    BasicDemuxer<TSPacketSize, StaticPIDFilter<0x100>, KeepNormalPayload> demuxer;
+    demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be synchronized");
+    TEST_ASSERT_TRUE(demuxer.getPacketFormat() == PacketFormat::TS, "Framing is fixed by the policy");
+
+    auto pids = demuxer.getDiscoveredPIDs();
+    TEST_ASSERT_EQ(pids.size(), 1, "Filter policy should drop other PIDs");
+    TEST_ASSERT_TRUE(pids.count(0x100) == 1, "0x100 should be stored");
+
+    auto iterations = demuxer.getIterationsSummary(0x100);
+    TEST_ASSERT_TRUE(iterations.size() > 0, "Should have iterations");
+    for (const auto& iter : iterations) {
+        TEST_ASSERT_TRUE(iter.payload_normal_size > 0, "Normal payload should be kept");
+        TEST_ASSERT_EQ(iter.payload_private_size, 0, "Private data should be dropped");
+    }
+
+    return true;
+}
+
+TEST(prefetch_distance_does_not_change_output) {
+    PacketGenerator gen;
+    gen.setSeed(7);
+
+    std::vector<uint8_t> data;
+    for (uint16_t pid = 0x100; pid < 0x106; ++pid) {
+        GeneratorConfig config;
+        config.pid = pid;
+        config.set_pusi = (pid & 1) != 0;
+        auto packets = gen.generateSequence(12, config);
+        data.insert(data.end(), packets.begin(), packets.end());
+    }
+
+    const uint8_t distances[] = {0, 1, 4, 31};
+    size_t expected_iterations = 0;
+
+    for (uint8_t distance : distances) {
+        DemuxerConfig config;
+        config.prefetch_distance = distance;
+
+        MPEGTSDemuxer demuxer(config);
+        demuxer.feedData(data.data(), data.size());
+
+        size_t iterations = 0;
+        for (uint16_t pid : demuxer.getDiscoveredPIDs()) {
+            iterations += demuxer.getIterationsSummary(pid).size();
+        }
+
+        if (distance == 0) {
+            expected_iterations = iterations;
+        }
+        TEST_ASSERT_EQ(iterations, expected_iterations, "Prefetching must not change results");
+    }
+
+    return true;
+}
+
+namespace {
+
+// Records what a sink receives: iteration count and payload bytes per PID
+class RecordingSink : public IterationSink {
+public:
+    void onIterationComplete(uint16_t pid, const IterationView& iteration) override {
+        ++iterations[pid];
+        for (size_t i = 0; i < iteration.getSegmentCount(); ++i) {
+            PayloadBuffer segment = iteration.getSegment(i);
+            payload[pid].insert(payload[pid].end(), segment.data, segment.data + segment.length);
+        }
+    }
+
+    std::map<uint16_t, size_t> iterations;
+    std::map<uint16_t, std::vector<uint8_t>> payload;
+};
+
+} // namespace
+
+TEST(iteration_sink_receives_without_retaining) {
+    PacketGenerator gen;
+    gen.setSeed(11);
+
+    std::vector<uint8_t> data;
+    for (uint16_t pid = 0x100; pid < 0x103; ++pid) {
+        GeneratorConfig config;
+        config.pid = pid;
+        config.set_pusi = true;
+        auto packets = gen.generateSequence(10, config);
+        data.insert(data.end(), packets.begin(), packets.end());
+    }
+
+    // Reference: iterations retained in storage
+    MPEGTSDemuxer stored;
+    stored.feedData(data.data(), data.size());
+
+    RecordingSink sink;
+    MPEGTSDemuxer streamed;
+    streamed.setIterationSink(&sink);
+    streamed.feedData(data.data(), data.size());
+    streamed.clearAll(); // Flushes open iterations to the sink
+
+    TEST_ASSERT_TRUE(streamed.getDiscoveredPIDs().empty(), "Nothing should be retained with a sink");
+    TEST_ASSERT_EQ(stored.getDiscoveredPIDs().size(), 3, "Reference should store all streams");
+
+    for (uint16_t pid : stored.getDiscoveredPIDs()) {
+        std::vector<uint8_t> expected;
+        size_t iterations = 0;
+        for (const auto& info : stored.getIterationsSummary(pid)) {
+            for (const auto& buffer : stored.getAllPayloads(pid, info.iteration_id)) {
+                expected.insert(expected.end(), buffer.data, buffer.data + buffer.length);
+            }
+            ++iterations;
+        }
+
+        TEST_ASSERT_EQ(sink.iterations[pid], iterations, "Sink should see every iteration");
+        TEST_ASSERT_TRUE(sink.payload[pid] == expected, "Sink payload should match storage");
+    }
+
+    streamed.setIterationSink(nullptr);
+    return true;
+}
+
+TEST(feed_block_references_payloads) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+    config.set_pusi = true;
+
+    auto data = gen.generateSequence(25, config);
+    const size_t lead = 5 * MPEGTS_PACKET_SIZE;
+
+    // Acquire sync first: packets fed before the lock go through the
+    // internal buffer and are copied
+    MPEGTSDemuxer demuxer;
+    demuxer.feedData(data.data(), lead);
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should synchronize on the lead packets");
+
+    auto* chunk = new IngestBlock(data.size() - lead);
+    PayloadBlockRef block(chunk);
+    std::copy(data.begin() + lead, data.end(), chunk->data());
+
+    size_t consumed = demuxer.feedBlock(block, chunk->data(), chunk->capacity());
+    TEST_ASSERT_EQ(consumed, chunk->capacity(), "Whole block should be consumed");
+
+    const uint8_t* begin = chunk->data();
+    const uint8_t* end = begin + chunk->capacity();
+    size_t referenced = 0;
+
+    for (const auto& info : demuxer.getIterationsSummary(0x100)) {
+        for (const auto& payload : demuxer.getAllPayloads(0x100, info.iteration_id)) {
+            if (payload.data >= begin && payload.data < end) {
+                referenced++;
+            }
+        }
+    }
+
+    TEST_ASSERT_EQ(referenced, 20, "Payloads parsed in place should point into the block");
+    TEST_ASSERT_TRUE(chunk->getRefCount() > 1, "Iterations should keep the block referenced");
+
+    demuxer.clearAll();
+    TEST_ASSERT_EQ(chunk->getRefCount(), 1, "Clearing should release the block");
+
+    return true;
+}
+
+TEST(unaligned_chunk_feeding) {
+    PacketGenerator gen;
+    MPEGTSDemuxer demuxer;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto data = gen.generateSequence(20, config);
+
+    // Chunks that never line up with packet boundaries
+    const size_t chunk_size = 1000;
+    for (size_t offset = 0; offset < data.size(); offset += chunk_size) {
+        size_t remaining = std::min(chunk_size, data.size() - offset);
+        demuxer.feedData(data.data() + offset, remaining);
+
+        // Only a partial tail packet should be carried over
+        TEST_ASSERT_TRUE(demuxer.getBufferOccupancy() < MPEGTS_PACKET_SIZE,
+                        "Only the partial tail packet should stay buffered");
+    }
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be synchronized");
+
+    auto iterations = demuxer.getIterationsSummary(0x100);
+    size_t packets = 0;
+    for (const auto& iter : iterations) {
+        packets += iter.packet_count;
+    }
+    TEST_ASSERT_EQ(packets, 20, "Every packet should be processed exactly once");
+
+    return true;
+}
+
+TEST(large_feed_not_truncated) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    // Garbage and packets together far exceed the buffer capacity
+    DemuxerConfig demuxer_config;
+    demuxer_config.buffer_capacity = 8 * 1024;
+
+    MPEGTSDemuxer demuxer(demuxer_config);
+
+    auto data = gen.generateGarbage(20000, false);
+    auto packets = gen.generateSequence(500, config);
+    data.insert(data.end(), packets.begin(), packets.end());
+
+    size_t consumed = demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_EQ(consumed, data.size(), "Whole input should be consumed");
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be synchronized");
+
+    auto iterations = demuxer.getIterationsSummary(0x100);
+    size_t total = 0;
+    for (const auto& iter : iterations) {
+        total += iter.packet_count;
+    }
+    TEST_ASSERT_EQ(total, 500, "No packet should be lost to buffer overflow");
+
+    return true;
+}
+
+TEST(program_table_filters_pids) {
+    PacketGenerator gen;
+    MPEGTSDemuxer demuxer;
+
+    ProgramTable table;
+    table.programs[1] = {0x100, 0x300};
+    demuxer.setProgramsTable(table);
+
+    // Three PIDs in bursts of 5 packets, CC continuous per PID
+    std::vector<uint8_t> data;
+    const uint16_t pids[] = {0x100, 0x200, 0x300};
+    for (size_t round = 0; round < 4; ++round) {
+        for (uint16_t pid : pids) {
+            GeneratorConfig config;
+            config.pid = pid;
+            config.starting_cc = static_cast<uint8_t>((round * 5) % 16);
+
+            auto burst = gen.generateSequence(5, config);
+            data.insert(data.end(), burst.begin(), burst.end());
+        }
+    }
+
+    demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be synchronized");
+
+    auto discovered = demuxer.getDiscoveredPIDs();
+    TEST_ASSERT_TRUE(discovered.count(0x100) == 1, "Program PID should be stored");
+    TEST_ASSERT_TRUE(discovered.count(0x300) == 1, "Program PID should be stored");
+    TEST_ASSERT_TRUE(discovered.count(0x200) == 0, "Filtered PID should not be stored");
+
+    size_t packets = 0;
+    for (const auto& iter : demuxer.getIterationsSummary(0x300)) {
+        packets += iter.packet_count;
+    }
+    TEST_ASSERT_EQ(packets, 20, "Every packet of a program PID should be kept");
+
+    return true;
+}
+
+TEST(program_table_set_while_iterations_open) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto data = gen.generateSequence(20, config);
+    const size_t half = 10 * MPEGTS_PACKET_SIZE;
+
+    MPEGTSDemuxer demuxer;
+    demuxer.feedData(data.data(), half);
+
+    // Clears storage while an iteration of 0x100 is still open
+    ProgramTable table;
+    table.programs[1] = {0x100};
+    demuxer.setProgramsTable(table);
+
+    demuxer.feedData(data.data() + half, data.size() - half);
+
+    size_t packets = 0;
+    for (const auto& iter : demuxer.getIterationsSummary(0x100)) {
+        packets += iter.packet_count;
+    }
+    TEST_ASSERT_EQ(packets, 10, "Only packets fed after the table should be stored");
+
+    return true;
+}
+
+TEST(null_packets_not_parsed) {
+    PacketGenerator gen;
+    MPEGTSDemuxer demuxer;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    GeneratorConfig null_config;
+    null_config.pid = PID_NULL;
+
+    // Null packets with a reserved adaptation_field_control would fail a
+    // full parse; the header-only stage must drop them first
+    auto null_packet = gen.generatePacket(null_config);
+    null_packet[3] &= 0xCF;
+
+    auto data = gen.generateSequence(5, config);
+    for (size_t i = 0; i < 10; ++i) {
+        data.insert(data.end(), null_packet.begin(), null_packet.end());
+    }
+    config.starting_cc = 5;
+    auto tail = gen.generateSequence(5, config);
+    data.insert(data.end(), tail.begin(), tail.end());
+
+    demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be synchronized");
+    TEST_ASSERT_EQ(demuxer.getStats().packets_skipped, 0, "Null packets are not errors");
+    TEST_ASSERT_EQ(demuxer.getStats().null_packets, 10, "Null packets should be counted");
+
+    auto pids = demuxer.getDiscoveredPIDs();
+    TEST_ASSERT_EQ(pids.size(), 1, "Only the program PID should be stored");
+
+    size_t packets = 0;
+    for (const auto& iter : demuxer.getIterationsSummary(0x100)) {
+        packets += iter.packet_count;
+    }
+    TEST_ASSERT_EQ(packets, 10, "Program packets around the null run should be kept");
+
+    return true;
+}
+
 // ============================================================================
 // Main
 // ============================================================================
@@ -1,5 +1,7 @@
 #include "test_framework.hpp"
 #include "mpegts_pcr.hpp"
+#include "mpegts_packet.hpp"
+#include "mpegts_demuxer.hpp"
 #include <cmath>
 
 using namespace mpegts;
@@ -256,6 +258,127 @@ TEST(pcr_manager_clear) {
     return true;
 }
 
+// ============================================================================
+// Adaptation Field Decoding Tests
+// ============================================================================
+
+static void writeClockReference(uint8_t* field, uint64_t base, uint16_t extension) {
+    field[0] = static_cast<uint8_t>(base >> 25);
+    field[1] = static_cast<uint8_t>(base >> 17);
+    field[2] = static_cast<uint8_t>(base >> 9);
+    field[3] = static_cast<uint8_t>(base >> 1);
+    field[4] = static_cast<uint8_t>(((base & 0x01) << 7) | 0x7E | ((extension >> 8) & 0x01));
+    field[5] = static_cast<uint8_t>(extension);
+}
+
+// Adaptation-only packet carrying a PCR
+static std::vector<uint8_t> pcrPacket(uint16_t pid, uint8_t cc, uint64_t base, uint16_t extension) {
+    std::vector<uint8_t> packet(MPEGTS_PACKET_SIZE, 0xFF);
+    packet[0] = MPEGTS_SYNC_BYTE;
+    packet[1] = static_cast<uint8_t>(pid >> 8);
+    packet[2] = static_cast<uint8_t>(pid);
+    packet[3] = 0x20 | cc;
+    packet[4] = 183;    // Adaptation field fills the packet
+    packet[5] = 0x10;   // PCR flag
+    writeClockReference(&packet[6], base, extension);
+    return packet;
+}
+
+TEST(adaptation_field_all_fields) {
+    std::vector<uint8_t> packet(MPEGTS_PACKET_SIZE, 0xFF);
+    packet[0] = MPEGTS_SYNC_BYTE;
+    packet[1] = 0x01;
+    packet[2] = 0x00;
+    packet[3] = 0x30;   // Adaptation + payload, CC 0
+
+    uint8_t* field = &packet[4];
+    field[0] = 1 + 6 + 6 + 1 + 3 + 12;  // Adaptation field length
+    field[1] = 0x1F;                    // PCR, OPCR, splicing point, private data, extension
+
+    const uint64_t pcr_base = 0x1ABCDEF01ULL;
+    const uint64_t opcr_base = 0x000012345ULL;
+    writeClockReference(&field[2], pcr_base, 299);
+    writeClockReference(&field[8], opcr_base, 7);
+
+    field[14] = 0xFD;                   // splice_countdown = -3
+    field[15] = 2;                      // Private data length
+    field[16] = 0xAA;
+    field[17] = 0xBB;
+
+    // Extension: ltw (valid, 0x1234), piecewise_rate 0x2ABCDE,
+    // seamless splice type 5 with DTS_next_AU 0x1DEADBEEF
+    const uint64_t dts = 0x1DEADBEEFULL;
+    field[18] = 11;
+    field[19] = 0xE0;
+    field[20] = 0x80 | 0x12;
+    field[21] = 0x34;
+    field[22] = 0xC0 | 0x2A;
+    field[23] = 0xBC;
+    field[24] = 0xDE;
+    field[25] = static_cast<uint8_t>(0x50 | ((dts >> 29) & 0x0E) | 0x01);
+    field[26] = static_cast<uint8_t>(dts >> 22);
+    field[27] = static_cast<uint8_t>(((dts >> 14) & 0xFE) | 0x01);
+    field[28] = static_cast<uint8_t>(dts >> 7);
+    field[29] = static_cast<uint8_t>(((dts << 1) & 0xFE) | 0x01);
+
+    TSPacket parsed;
+    TEST_ASSERT_TRUE(parsed.parse(packet.data()), "Packet should parse");
+
+    const TSAdaptationField* adapt = parsed.getAdaptationField();
+    TEST_ASSERT_TRUE(adapt != nullptr, "Adaptation field should be present");
+    TEST_ASSERT_EQ(adapt->pcr_base, pcr_base, "PCR base should be decoded");
+    TEST_ASSERT_EQ(adapt->pcr_extension, 299, "PCR extension should be decoded");
+    TEST_ASSERT_EQ(adapt->opcr_base, opcr_base, "OPCR base should be decoded");
+    TEST_ASSERT_EQ(adapt->opcr_extension, 7, "OPCR extension should be decoded");
+    TEST_ASSERT_EQ(adapt->splice_countdown, -3, "Splice countdown is signed");
+    TEST_ASSERT_EQ(parsed.getPrivateDataLength(), 2, "Private data should follow");
+    TEST_ASSERT_EQ(parsed.getPrivateData()[1], 0xBB, "Private data should be in place");
+
+    TEST_ASSERT_TRUE(adapt->ltw_flag && adapt->ltw_valid, "LTW should be present and valid");
+    TEST_ASSERT_EQ(adapt->ltw_offset, 0x1234, "LTW offset should be decoded");
+    TEST_ASSERT_EQ(adapt->piecewise_rate, 0x2ABCDEu, "Piecewise rate should be decoded");
+    TEST_ASSERT_EQ(adapt->splice_type, 5, "Splice type should be decoded");
+    TEST_ASSERT_EQ(adapt->dts_next_au, dts, "DTS_next_AU should be decoded");
+
+    TEST_ASSERT_EQ(parsed.getPayloadSize(), MPEGTS_PACKET_SIZE - 4 - 1 - field[0],
+                  "Payload should follow the adaptation field");
+
+    return true;
+}
+
+TEST(adaptation_field_truncated_rejected) {
+    auto packet = pcrPacket(0x100, 0, 0, 0);
+    packet[4] = 4;  // Too short for the PCR
+
+    TSPacket parsed;
+    TEST_ASSERT_FALSE(parsed.parse(packet.data()), "Truncated PCR should be rejected");
+
+    packet = pcrPacket(0x100, 0, 0, 0);
+    packet[5] = 0x01;   // Extension claiming more bytes than the field holds
+    packet[6] = 200;
+    TEST_ASSERT_FALSE(parsed.parse(packet.data()), "Oversized extension should be rejected");
+
+    return true;
+}
+
+TEST(demuxer_pcr_values_reach_manager) {
+    MPEGTSDemuxer demuxer;
+
+    std::vector<uint8_t> data;
+    for (uint8_t i = 0; i < 4; ++i) {
+        auto packet = pcrPacket(0x100, 0, 90000 * (i + 1), 100);
+        data.insert(data.end(), packet.begin(), packet.end());
+    }
+    demuxer.feedData(data.data(), data.size());
+
+    auto last = demuxer.getLastPCR(0x100);
+    TEST_ASSERT_TRUE(last.has_value(), "PCR should be recorded");
+    TEST_ASSERT_EQ(last->base, 360000u, "Last PCR base should be decoded");
+    TEST_ASSERT_EQ(last->extension, 100, "Last PCR extension should be decoded");
+
+    return true;
+}
+
 // ============================================================================
 // Main
 // ============================================================================
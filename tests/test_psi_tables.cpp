@@ -219,6 +219,192 @@ TEST(pat_get_pmt_pid) {
     return true;
 }
 
+// ============================================================================
+// PID Role Tests
+// ============================================================================
+
+static void appendCRC(std::vector<uint8_t>& section) {
+    uint32_t crc = PSIParser::calculateCRC32(section.data(), section.size());
+    section.push_back((crc >> 24) & 0xFF);
+    section.push_back((crc >> 16) & 0xFF);
+    section.push_back((crc >> 8) & 0xFF);
+    section.push_back(crc & 0xFF);
+}
+
+// One section in one packet (PUSI, pointer field 0)
+static std::vector<uint8_t> sectionPacket(uint16_t pid, uint8_t cc,
+                                          const std::vector<uint8_t>& section) {
+    std::vector<uint8_t> packet(MPEGTS_PACKET_SIZE, 0xFF);
+    packet[0] = MPEGTS_SYNC_BYTE;
+    packet[1] = 0x40 | static_cast<uint8_t>(pid >> 8);
+    packet[2] = static_cast<uint8_t>(pid);
+    packet[3] = 0x10 | cc;
+    packet[4] = 0x00;
+    std::copy(section.begin(), section.end(), packet.begin() + 5);
+    return packet;
+}
+
+// Adaptation-only packet with PCR base = 90000 * seconds
+static std::vector<uint8_t> pcrPacket(uint16_t pid, uint64_t seconds) {
+    const uint64_t base = 90000 * seconds;
+    std::vector<uint8_t> packet(MPEGTS_PACKET_SIZE, 0xFF);
+    packet[0] = MPEGTS_SYNC_BYTE;
+    packet[1] = static_cast<uint8_t>(pid >> 8);
+    packet[2] = static_cast<uint8_t>(pid);
+    packet[3] = 0x20;
+    packet[4] = 183;
+    packet[5] = 0x10;
+    packet[6] = static_cast<uint8_t>(base >> 25);
+    packet[7] = static_cast<uint8_t>(base >> 17);
+    packet[8] = static_cast<uint8_t>(base >> 9);
+    packet[9] = static_cast<uint8_t>(base >> 1);
+    packet[10] = static_cast<uint8_t>(((base & 0x01) << 7) | 0x7E);
+    packet[11] = 0x00;
+    return packet;
+}
+
+TEST(pcr_role_follows_pmt) {
+    // PAT: program 1 -> PMT on 0x1000
+    std::vector<uint8_t> pat = {0x00, 0xB0, 0x0D, 0x00, 0x01, 0xC1, 0x00, 0x00,
+                                0x00, 0x01, 0xF0, 0x00};
+    appendCRC(pat);
+
+    // PMT: PCR on 0x101, one H.264 stream on 0x100
+    std::vector<uint8_t> pmt = {0x02, 0xB0, 0x12, 0x00, 0x01, 0xC1, 0x00, 0x00,
+                                0xE1, 0x01, 0xF0, 0x00,
+                                0x1B, 0xE1, 0x00, 0xF0, 0x00};
+    appendCRC(pmt);
+
+    std::vector<uint8_t> data;
+    auto append = [&data](const std::vector<uint8_t>& packet) {
+        data.insert(data.end(), packet.begin(), packet.end());
+    };
+
+    // Repeated PAT (the repetitions must not reset the PMT accumulator)
+    for (uint8_t cc = 0; cc < 3; ++cc) {
+        append(sectionPacket(PID_PAT, cc, pat));
+    }
+    append(sectionPacket(0x1000, 0, pmt));
+    append(sectionPacket(PID_PAT, 3, pat));
+
+    // PCR flags on a PID the PMT does not name are not program clocks
+    append(pcrPacket(0x100, 1));
+    append(pcrPacket(0x101, 2));
+    append(pcrPacket(0x101, 3));
+
+    MPEGTSDemuxer demuxer;
+    demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be synchronized");
+    TEST_ASSERT_FALSE(demuxer.getLastPCR(0x100).has_value(), "0x100 is not the PCR PID");
+
+    auto last = demuxer.getLastPCR(0x101);
+    TEST_ASSERT_TRUE(last.has_value(), "PCR PID should be tracked");
+    TEST_ASSERT_EQ(last->base, 270000u, "Last PCR should be recorded");
+
+    return true;
+}
+
+TEST(pcr_tracked_outside_program_table_before_pmt) {
+    std::vector<uint8_t> data;
+    for (uint64_t seconds = 1; seconds <= 4; ++seconds) {
+        auto packet = pcrPacket(0x101, seconds);
+        data.insert(data.end(), packet.begin(), packet.end());
+    }
+
+    // 0x101 is not in the table, but no PMT has named the PCR PID yet
+    ProgramTable table;
+    table.programs[1] = {0x100};
+
+    MPEGTSDemuxer demuxer;
+    demuxer.setProgramsTable(table);
+    demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be synchronized");
+
+    auto last = demuxer.getLastPCR(0x101);
+    TEST_ASSERT_TRUE(last.has_value(), "PCR outside the table should be tracked");
+    TEST_ASSERT_EQ(last->base, 360000u, "Last PCR should be recorded");
+    TEST_ASSERT_TRUE(demuxer.getIterationsSummary(0x101).empty(),
+                     "PCR-only PID outside the table should not be stored");
+
+    return true;
+}
+
+TEST(ignored_pids_not_parsed_before_pmt) {
+    std::vector<uint8_t> data;
+    for (uint64_t seconds = 1; seconds <= 3; ++seconds) {
+        auto packet = pcrPacket(0x101, seconds);
+        data.insert(data.end(), packet.begin(), packet.end());
+    }
+
+    // Adaptation field overrunning the packet, no PCR_flag: fails to
+    // parse, so it is counted as skipped only if it is parsed
+    auto corrupted = pcrPacket(0x102, 0);
+    corrupted[4] = 200;
+    corrupted[5] = 0x00;
+    data.insert(data.end(), corrupted.begin(), corrupted.end());
+
+    ProgramTable table;
+    table.programs[1] = {0x100};
+
+    MPEGTSDemuxer demuxer;
+    demuxer.setProgramsTable(table);
+    demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be synchronized");
+    TEST_ASSERT_TRUE(demuxer.getLastPCR(0x101).has_value(), "PCR should be probed");
+    TEST_ASSERT_EQ(demuxer.getStats().packets_skipped, 0u,
+                   "Ignored PID without a PCR should not be parsed");
+
+    // The same packet on a table PID is parsed and skipped
+    corrupted[1] = 0x01;
+    corrupted[2] = 0x00;
+    demuxer.feedData(corrupted.data(), corrupted.size());
+
+    TEST_ASSERT_EQ(demuxer.getStats().packets_skipped, 1u,
+                   "Table PID should be parsed");
+
+    return true;
+}
+
+TEST(pcr_applies_to_later_packets_only) {
+    std::vector<uint8_t> data;
+    auto append = [&data](const std::vector<uint8_t>& packet) {
+        data.insert(data.end(), packet.begin(), packet.end());
+    };
+
+    // All in one batch: each iteration of 0x100 (no PES header) starts
+    // at the PCR received before it, not at a later one
+    append(pcrPacket(0x101, 1));
+    append(sectionPacket(0x100, 0, {}));
+    append(pcrPacket(0x101, 5));
+    append(sectionPacket(0x100, 1, {}));
+    append(pcrPacket(0x101, 9));
+
+    class TimestampSink : public IterationSink {
+    public:
+        void onIterationComplete(uint16_t pid, const IterationView& iteration) override {
+            if (pid == 0x100) {
+                timestamps.push_back(iteration.getData().timestamp);
+            }
+        }
+        std::vector<uint64_t> timestamps;
+    } sink;
+
+    MPEGTSDemuxer demuxer;
+    demuxer.setIterationSink(&sink);
+    demuxer.feedData(data.data(), data.size());
+    demuxer.clearAll();
+    demuxer.setIterationSink(nullptr);
+
+    TEST_ASSERT_EQ(sink.timestamps.size(), 2u, "Should deliver two iterations");
+    TEST_ASSERT_EQ(sink.timestamps[0], 90000u, "First iteration starts at the first PCR");
+    TEST_ASSERT_EQ(sink.timestamps[1], 450000u, "Second iteration starts at the second PCR");
+
+    return true;
+}
+
 // ============================================================================
 // Main
 // ============================================================================
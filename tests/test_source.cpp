@@ -0,0 +1,111 @@
+#include "test_framework.hpp"
+#include "test_packet_generator.hpp"
+#include "mpegts_demuxer.hpp"
+#include "mpegts_source.hpp"
+#include <cstdio>
+#include <fstream>
+
+using namespace mpegts;
+using namespace test;
+
+static const char* TEST_FILE = "test_source_recording.ts";
+
+static bool writeFile(const char* path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+// ============================================================================
+// Mapped Source Tests
+// ============================================================================
+
+TEST(source_windows_are_packet_aligned) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto data = gen.generateSequence(50, config);
+    data.resize(data.size() + 100); // Truncated tail
+    TEST_ASSERT_TRUE(writeFile(TEST_FILE, data), "Should write test file");
+
+    MappedSource source;
+    TEST_ASSERT_TRUE(source.open(TEST_FILE), "Should map file");
+    TEST_ASSERT_EQ(source.size(), data.size(), "Should map whole file");
+
+    const uint8_t* window = nullptr;
+    size_t length = source.nextWindow(window, 1000, MPEGTS_PACKET_SIZE);
+
+    TEST_ASSERT_TRUE(window == source.data(), "Window should point into the mapping");
+    TEST_ASSERT_EQ(length, 5 * MPEGTS_PACKET_SIZE, "Window should be whole packets");
+
+    source.advance(length);
+    TEST_ASSERT_EQ(source.position(), length, "Cursor should advance");
+
+    // Last window covers the rest of the file, truncated packet included
+    source.advance(data.size() - length - 200);
+    length = source.nextWindow(window, 1000, MPEGTS_PACKET_SIZE);
+    TEST_ASSERT_EQ(length, 200, "Last window should reach the file end");
+
+    source.advance(length);
+    TEST_ASSERT_TRUE(source.atEnd(), "Cursor should be at the end");
+
+    source.close();
+    std::remove(TEST_FILE);
+
+    return true;
+}
+
+TEST(source_missing_file) {
+    MappedSource source;
+    TEST_ASSERT_FALSE(source.open("does_not_exist.ts"), "Should fail on missing file");
+    TEST_ASSERT_FALSE(source.isOpen(), "Should not be open");
+
+    MPEGTSDemuxer demuxer;
+    TEST_ASSERT_FALSE(demuxer.feedFile("does_not_exist.ts"), "Should report failure");
+
+    return true;
+}
+
+TEST(feed_file_demuxes_recording) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    // Larger than one feed window, with a garbage prefix
+    auto data = gen.generateGarbage(333, false);
+    auto packets = gen.generateSequence(8000, config);
+    data.insert(data.end(), packets.begin(), packets.end());
+    TEST_ASSERT_TRUE(writeFile(TEST_FILE, data), "Should write test file");
+
+    MappedSource source;
+    TEST_ASSERT_TRUE(source.open(TEST_FILE), "Should map file");
+
+    MPEGTSDemuxer demuxer;
+    size_t consumed = demuxer.feedFile(source);
+
+    TEST_ASSERT_EQ(consumed, data.size(), "Whole file should be consumed");
+    TEST_ASSERT_TRUE(source.atEnd(), "Cursor should be at the end");
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be synchronized");
+
+    size_t total = 0;
+    for (const auto& iter : demuxer.getIterationsSummary(0x100)) {
+        total += iter.packet_count;
+    }
+    TEST_ASSERT_EQ(total, 8000, "Every packet should be demuxed");
+
+    source.close();
+    std::remove(TEST_FILE);
+
+    return true;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main() {
+    return TestRegistry::instance().runAll();
+}
@@ -0,0 +1,307 @@
+#include "test_framework.hpp"
+#include "mpegts_demuxer.hpp"
+#include "mpegts_storage.hpp"
+#include <deque>
+
+using namespace mpegts;
+using namespace test;
+
+// Iteration with `bytes` payload bytes, optionally stamped
+static IterationData makeIteration(size_t bytes, bool timed = false, uint64_t timestamp = 0) {
+    static const std::vector<uint8_t> pattern(4096, 0xAB);
+
+    IterationData data;
+    data.payload_size = bytes;
+
+    PayloadSegment segment;
+    segment.data = pattern.data();
+    segment.length = bytes;
+    data.payloads.push_back(segment);
+
+    data.has_timestamp = timed;
+    data.timestamp = timestamp;
+    return data;
+}
+
+static std::vector<uint32_t> storedIDs(const DemuxerStreamStorage& storage, uint16_t pid) {
+    std::vector<uint32_t> ids;
+    if (const auto* stream = storage.getStream(pid)) {
+        for (const auto& entry : stream->getIterations()) {
+            ids.push_back(entry.first);
+        }
+    }
+    return ids;
+}
+
+// ============================================================================
+// Arena Tests
+// ============================================================================
+
+TEST(arena_pages_reused_in_steady_state) {
+    PayloadArena arena(4096);
+
+    std::vector<uint8_t> chunk(184);
+    std::deque<std::vector<PayloadBlockRef>> iterations;
+
+    // Iterations of 10 segments, at most 8 kept: a few pages cycle
+    for (int i = 0; i < 1000; ++i) {
+        std::vector<PayloadBlockRef> refs(10);
+        for (size_t s = 0; s < refs.size(); ++s) {
+            chunk[0] = static_cast<uint8_t>(i);
+            const uint8_t* copy = arena.store(chunk.data(), chunk.size(), refs[s]);
+            TEST_ASSERT_EQ(copy[0], static_cast<uint8_t>(i), "Bytes should be copied");
+        }
+        iterations.push_back(std::move(refs));
+        if (iterations.size() > 8) {
+            iterations.pop_front();
+        }
+    }
+
+    const size_t allocations = arena.getPageAllocations();
+    TEST_ASSERT_TRUE(allocations <= 8, "Pages should be recycled");
+
+    for (int i = 0; i < 1000; ++i) {
+        std::vector<PayloadBlockRef> refs(10);
+        for (auto& ref : refs) {
+            arena.store(chunk.data(), chunk.size(), ref);
+        }
+        iterations.push_back(std::move(refs));
+        iterations.pop_front();
+    }
+
+    TEST_ASSERT_EQ(arena.getPageAllocations(), allocations, "Steady state should not allocate");
+
+    return true;
+}
+
+TEST(arena_oversized_and_orphaned_pages) {
+    PayloadBlockRef large;
+    PayloadBlockRef small;
+    std::vector<uint8_t> big(10000, 0x5A);
+
+    {
+        PayloadArena arena(1024);
+        const uint8_t* copy = arena.store(big.data(), big.size(), large);
+        TEST_ASSERT_TRUE(copy[9999] == 0x5A, "Oversized segment should be stored whole");
+
+        arena.store(big.data(), 100, small);
+        TEST_ASSERT_TRUE(large.get() != small.get(), "Oversized segment gets its own page");
+    }
+
+    // Pages outlive the arena while referenced
+    TEST_ASSERT_EQ(large.get()->getRefCount(), 1, "Reference should survive the arena");
+    large.reset();
+    small.reset();
+
+    return true;
+}
+
+TEST(add_iteration_moves_segments) {
+    PayloadArena arena;
+    DemuxerStreamStorage storage;
+
+    std::vector<uint8_t> chunk(184, 0x33);
+
+    IterationData data;
+    PayloadSegment& segment = data.payloads.emplace_back();
+    segment.length = chunk.size();
+    segment.data = arena.store(chunk.data(), chunk.size(), segment.block);
+    data.payload_size = chunk.size();
+
+    const uint8_t* bytes = segment.data;
+    PayloadBlock* page = segment.block.get();
+    const uint32_t refs = page->getRefCount();
+
+    storage.addIteration(0x100, 1, std::move(data));
+
+    const IterationData* stored = storage.getStream(0x100)->getIteration(1);
+    TEST_ASSERT_TRUE(stored != nullptr, "Iteration should be stored");
+    TEST_ASSERT_TRUE(stored->payloads[0].data == bytes, "Payload should not be copied");
+    TEST_ASSERT_EQ(page->getRefCount(), refs, "Segments should be moved, not copied");
+
+    return true;
+}
+
+// ============================================================================
+// Retention Tests
+// ============================================================================
+
+TEST(retention_stream_iteration_limit) {
+    DemuxerStreamStorage storage;
+
+    RetentionPolicy policy;
+    policy.max_iterations = 3;
+    storage.setRetentionPolicy(0x100, policy);
+
+    for (uint32_t id = 1; id <= 10; ++id) {
+        storage.addIteration(0x100, id, makeIteration(100));
+        storage.addIteration(0x101, 100 + id, makeIteration(100));
+    }
+
+    TEST_ASSERT_TRUE(storedIDs(storage, 0x100) == std::vector<uint32_t>({8, 9, 10}),
+                     "Only the newest iterations should be kept");
+    TEST_ASSERT_EQ(storage.getStream(0x101)->getIterationCount(), 10,
+                   "Other streams should not be limited");
+    TEST_ASSERT_EQ(storage.getUsage().iterations, 13, "Usage should track evictions");
+    TEST_ASSERT_EQ(storage.getUsage().bytes, 1300, "Usage should track evicted bytes");
+
+    return true;
+}
+
+TEST(retention_global_bytes_evicts_oldest_first) {
+    DemuxerStreamStorage storage;
+
+    RetentionPolicy policy;
+    policy.max_bytes = 1000;
+    storage.setRetentionPolicy(policy);
+
+    // Interleaved streams: the global limit removes the oldest of all
+    uint32_t id = 1;
+    for (int i = 0; i < 10; ++i) {
+        storage.addIteration(0x100, id++, makeIteration(100));
+        storage.addIteration(0x101, id++, makeIteration(150));
+    }
+
+    TEST_ASSERT_TRUE(storage.getUsage().bytes <= 1000, "Byte limit should hold");
+    TEST_ASSERT_EQ(storage.getUsage().bytes,
+                   storage.getStream(0x100)->getPayloadBytes() +
+                   storage.getStream(0x101)->getPayloadBytes(),
+                   "Usage should match the streams");
+    TEST_ASSERT_TRUE(storedIDs(storage, 0x100) == std::vector<uint32_t>({13, 15, 17, 19}),
+                     "Oldest iterations should be evicted first");
+    TEST_ASSERT_TRUE(storedIDs(storage, 0x101) == std::vector<uint32_t>({14, 16, 18, 20}),
+                     "Oldest iterations should be evicted first");
+
+    return true;
+}
+
+TEST(retention_global_limit_skips_removed_iterations) {
+    DemuxerStreamStorage storage;
+
+    // Many iterations removed by the application leave stale entries
+    for (uint32_t id = 1; id <= 500; ++id) {
+        storage.addIteration(0x100, id, makeIteration(10));
+        if (id % 5 != 0) {
+            storage.getOrCreateStream(0x100).removeIteration(id);
+        }
+    }
+    storage.clearStream(0x100);
+
+    for (uint32_t id = 501; id <= 520; ++id) {
+        storage.addIteration(0x100, id, makeIteration(10));
+    }
+
+    RetentionPolicy policy;
+    policy.max_iterations = 5;
+    storage.setRetentionPolicy(policy);
+
+    TEST_ASSERT_TRUE(storedIDs(storage, 0x100) ==
+                     std::vector<uint32_t>({516, 517, 518, 519, 520}),
+                     "Limit should keep the newest iterations");
+
+    return true;
+}
+
+TEST(retention_max_age) {
+    DemuxerStreamStorage storage;
+
+    RetentionPolicy policy;
+    policy.max_age = 90000; // 1 second
+    storage.setRetentionPolicy(policy);
+
+    // One untimed iteration before the first timestamp, then 0.25 s steps
+    storage.addIteration(0x100, 1, makeIteration(10));
+    for (uint32_t id = 2; id <= 10; ++id) {
+        storage.addIteration(0x100, id, makeIteration(10, true, (id - 2) * 22500));
+    }
+
+    TEST_ASSERT_TRUE(storedIDs(storage, 0x100) == std::vector<uint32_t>({6, 7, 8, 9, 10}),
+                     "Iterations older than 1 s should be evicted");
+
+    // Untimed iterations inherit the previous time and are kept
+    storage.addIteration(0x100, 11, makeIteration(10));
+    TEST_ASSERT_EQ(storage.getStream(0x100)->getIterationCount(), 6,
+                   "Untimed iteration should not advance the clock");
+
+    return true;
+}
+
+TEST(retention_max_age_wraps) {
+    DemuxerStreamStorage storage;
+
+    RetentionPolicy policy;
+    policy.max_age = 90000;
+    storage.setRetentionPolicy(0x100, policy);
+
+    // 33-bit PTS wraps between the two iterations (0.5 s apart)
+    const uint64_t wrap = uint64_t(1) << 33;
+    storage.addIteration(0x100, 1, makeIteration(10, true, wrap - 22500));
+    storage.addIteration(0x100, 2, makeIteration(10, true, 22500));
+
+    TEST_ASSERT_EQ(storage.getStream(0x100)->getIterationCount(), 2,
+                   "Wrapped timestamps should give the real age");
+
+    return true;
+}
+
+TEST(retention_max_age_out_of_order) {
+    DemuxerStreamStorage storage;
+
+    RetentionPolicy policy;
+    policy.max_age = 90000;
+    storage.setRetentionPolicy(0x100, policy);
+
+    // B-frame order: PTS steps back by a frame now and then
+    const uint64_t start = 60 * 90000;
+    const uint64_t frame = 3600;
+    const uint64_t frames[] = {0, 3, 1, 2, 6, 4, 5};
+    uint32_t id = 1;
+    for (uint64_t index : frames) {
+        storage.addIteration(0x100, id++, makeIteration(10, true, start + index * frame));
+    }
+
+    TEST_ASSERT_EQ(storage.getStream(0x100)->getIterationCount(), 7,
+                   "Reordered PTS should not evict anything");
+
+    // Backward clock jump of a minute: older iterations go, the new ones stay
+    storage.addIteration(0x100, id++, makeIteration(10, true, 0));
+    storage.addIteration(0x100, id++, makeIteration(10, true, 3600));
+
+    TEST_ASSERT_TRUE(storedIDs(storage, 0x100) == std::vector<uint32_t>({8, 9}),
+                     "Iterations before a clock jump should be evicted");
+
+    return true;
+}
+
+TEST(demuxer_retention_from_config) {
+    DemuxerConfig config;
+    config.retention.max_iterations = 4;
+
+    MPEGTSDemuxer demuxer(config);
+
+    // Every packet starts an iteration
+    std::vector<uint8_t> data;
+    for (uint8_t cc = 0; cc < 20; ++cc) {
+        std::vector<uint8_t> packet(MPEGTS_PACKET_SIZE, 0xFF);
+        packet[0] = MPEGTS_SYNC_BYTE;
+        packet[1] = 0x40 | 0x01;
+        packet[2] = 0x00;
+        packet[3] = 0x10 | (cc & 0x0F);
+        data.insert(data.end(), packet.begin(), packet.end());
+    }
+
+    demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_EQ(demuxer.getIterationsSummary(0x100).size(), 4,
+                   "Global limit from the configuration should apply");
+
+    return true;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main() {
+    return TestRegistry::instance().runAll();
+}
@@ -1,6 +1,7 @@
 #include "test_framework.hpp"
 #include "test_packet_generator.hpp"
 #include "mpegts_demuxer.hpp"
+#include "mpegts_sync.hpp"
 
 using namespace mpegts;
 using namespace test;
@@ -268,6 +269,393 @@ TEST(sync_rapid_resync) {
     return true;
 }
 
+TEST(sync_garbage_burst_is_dropped) {
+    PacketGenerator gen;
+    MPEGTSDemuxer demuxer;
+
+    // Long garbage burst fed in small chunks
+    for (int i = 0; i < 200; ++i) {
+        auto garbage = gen.generateGarbage(500, false);
+        demuxer.feedData(garbage.data(), garbage.size());
+
+        // Scanned bytes must not pile up in the buffer
+        TEST_ASSERT_TRUE(demuxer.getBufferOccupancy() < MPEGTS_PACKET_SIZE * 3,
+                        "Proven garbage should be dropped");
+    }
+
+    TEST_ASSERT_FALSE(demuxer.isSynchronized(), "Should not sync on garbage");
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto data = gen.generateSequence(6, config);
+    demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should sync after the burst");
+
+    auto iterations = demuxer.getIterationsSummary(0x100);
+    size_t packets = 0;
+    for (const auto& iter : iterations) {
+        packets += iter.packet_count;
+    }
+    TEST_ASSERT_EQ(packets, 6, "Every packet after the burst should be processed");
+
+    return true;
+}
+
+// ============================================================================
+// Lock State Machine
+// ============================================================================
+
+static size_t countPackets(const MPEGTSDemuxer& demuxer, uint16_t pid) {
+    size_t packets = 0;
+    for (const auto& iter : demuxer.getIterationsSummary(pid)) {
+        packets += iter.packet_count;
+    }
+    return packets;
+}
+
+TEST(lock_survives_single_corrupted_packet) {
+    PacketGenerator gen;
+    MPEGTSDemuxer demuxer;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto data = gen.generateSequence(10, config);
+    data[5 * MPEGTS_PACKET_SIZE] = 0x00; // Bit error in sync byte
+
+    demuxer.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should stay locked");
+    TEST_ASSERT_EQ(demuxer.getStats().sync_losses, 0, "Should not lose lock");
+    TEST_ASSERT_EQ(demuxer.getStats().packets_skipped, 1, "Should skip one packet");
+    TEST_ASSERT_EQ(countPackets(demuxer, 0x100), 9, "Other packets should be kept");
+
+    return true;
+}
+
+TEST(lock_lost_after_consecutive_misses) {
+    PacketGenerator gen;
+    MPEGTSDemuxer demuxer;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto data = gen.generateSequence(10, config);
+    for (size_t i = 4; i < 7; ++i) {
+        data[i * MPEGTS_PACKET_SIZE] = 0x00;
+    }
+
+    // Corrupted run split across two feeds
+    const size_t split = 5 * MPEGTS_PACKET_SIZE + 17;
+    demuxer.feedData(data.data(), split);
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should still be locked mid-run");
+
+    demuxer.feedData(data.data() + split, data.size() - split);
+
+    TEST_ASSERT_EQ(demuxer.getStats().sync_losses, 1, "Should lose lock once");
+    TEST_ASSERT_EQ(demuxer.getStats().sync_acquisitions, 2, "Should reacquire lock");
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should be locked again");
+    TEST_ASSERT_EQ(countPackets(demuxer, 0x100), 7, "Packets around the run should be kept");
+
+    return true;
+}
+
+TEST(lock_thresholds_configurable) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    DemuxerConfig demuxer_config;
+    demuxer_config.sync_acquire_count = 5;
+    demuxer_config.sync_loss_count = 1;
+
+    MPEGTSDemuxer demuxer(demuxer_config);
+
+    auto data = gen.generateSequence(12, config);
+    data[8 * MPEGTS_PACKET_SIZE] = 0x00;
+
+    demuxer.feedData(data.data(), 4 * MPEGTS_PACKET_SIZE);
+    TEST_ASSERT_FALSE(demuxer.isSynchronized(), "4 packets should not acquire lock");
+
+    demuxer.feedData(data.data() + 4 * MPEGTS_PACKET_SIZE, MPEGTS_PACKET_SIZE);
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "5 packets should acquire lock");
+
+    demuxer.feedData(data.data() + 5 * MPEGTS_PACKET_SIZE, 4 * MPEGTS_PACKET_SIZE);
+    TEST_ASSERT_FALSE(demuxer.isSynchronized(), "Single miss should drop lock");
+    TEST_ASSERT_EQ(demuxer.getStats().sync_losses, 1, "Should count the loss");
+
+    return true;
+}
+
+TEST(lock_kept_on_transport_error_packets) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto data = gen.generateSequence(10, config);
+    data[4 * MPEGTS_PACKET_SIZE + 1] |= 0x80; // Demodulator-flagged packets
+    data[5 * MPEGTS_PACKET_SIZE + 1] |= 0x80;
+    data[8 * MPEGTS_PACKET_SIZE + 1] |= 0x80;
+
+    // Default policy: count and drop
+    MPEGTSDemuxer dropping;
+    dropping.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(dropping.isSynchronized(), "Should stay locked");
+    TEST_ASSERT_EQ(dropping.getStats().sync_losses, 0, "TEI must not cause resync");
+    TEST_ASSERT_EQ(dropping.getStats().tei_packets, 3, "Should count TEI packets");
+    TEST_ASSERT_EQ(countPackets(dropping, 0x100), 7, "TEI packets should be dropped");
+
+    // Pass-through policy: keep them, flag the iteration
+    DemuxerConfig demuxer_config;
+    demuxer_config.tei_policy = TEIPolicy::PASS_FLAGGED;
+
+    MPEGTSDemuxer passing(demuxer_config);
+    passing.feedData(data.data(), data.size());
+
+    TEST_ASSERT_EQ(passing.getStats().tei_packets, 3, "Should count TEI packets");
+    TEST_ASSERT_EQ(countPackets(passing, 0x100), 10, "TEI packets should be kept");
+
+    auto iterations = passing.getIterationsSummary(0x100);
+    TEST_ASSERT_TRUE(!iterations.empty() && iterations[0].has_transport_error,
+                    "Iteration should be flagged");
+
+    return true;
+}
+
+// ============================================================================
+// Sync Byte Scanner
+// ============================================================================
+
+TEST(sync_scanner_finds_periodic_candidate) {
+    PacketGenerator gen;
+
+    auto garbage = gen.generateGarbage(1000, false);
+
+    // Lone and paired sync bytes that must be rejected
+    garbage[10] = MPEGTS_SYNC_BYTE;
+    garbage[50] = MPEGTS_SYNC_BYTE;
+    garbage[50 + MPEGTS_PACKET_SIZE] = MPEGTS_SYNC_BYTE;
+
+    // First position with sync bytes at +0, +188 and +376
+    const size_t expected = 333;
+    garbage[expected] = MPEGTS_SYNC_BYTE;
+    garbage[expected + MPEGTS_PACKET_SIZE] = MPEGTS_SYNC_BYTE;
+    garbage[expected + MPEGTS_PACKET_SIZE * 2] = MPEGTS_SYNC_BYTE;
+
+    std::cout << "  Detected kernel: "
+              << getSyncScanKernelName(detectSyncScanKernel()) << "\n";
+
+    TEST_ASSERT_EQ(findSyncCandidate(garbage.data(), garbage.size()), expected,
+                  "Should find the periodic candidate");
+
+    // Candidate whose third sync byte lies past the end is not reported
+    TEST_ASSERT_EQ(findSyncCandidate(garbage.data(), expected + MPEGTS_PACKET_SIZE * 2),
+                  expected + MPEGTS_PACKET_SIZE * 2,
+                  "Should not report a truncated candidate");
+
+    return true;
+}
+
+TEST(sync_scanner_kernels_agree) {
+    PacketGenerator gen;
+    gen.setSeed(4242);
+
+    const SyncScanKernel kernels[] = {
+        SyncScanKernel::SCALAR, SyncScanKernel::SSE2,
+        SyncScanKernel::AVX2, SyncScanKernel::AVX512
+    };
+
+    for (int round = 0; round < 50; ++round) {
+        auto data = gen.generateGarbage(2048 + round * 7, true);
+
+        // Plant a candidate at a position that exercises the vector tails
+        size_t planted = 100 + round * 23;
+        data[planted] = MPEGTS_SYNC_BYTE;
+        data[planted + MPEGTS_PACKET_SIZE] = MPEGTS_SYNC_BYTE;
+        data[planted + MPEGTS_PACKET_SIZE * 2] = MPEGTS_SYNC_BYTE;
+
+        size_t expected = findSyncCandidate(SyncScanKernel::SCALAR,
+                                            data.data(), data.size());
+        TEST_ASSERT_TRUE(expected <= planted, "Scalar should find planted candidate");
+
+        for (SyncScanKernel kernel : kernels) {
+            if (!isSyncScanKernelSupported(kernel)) {
+                continue;
+            }
+            TEST_ASSERT_EQ(findSyncCandidate(kernel, data.data(), data.size()), expected,
+                          "Kernel should match scalar result");
+        }
+    }
+
+    return true;
+}
+
+TEST(null_run_kernels_agree) {
+    PacketGenerator gen;
+    gen.setSeed(777);
+
+    const SyncScanKernel kernels[] = {
+        SyncScanKernel::SCALAR, SyncScanKernel::SSE2,
+        SyncScanKernel::AVX2, SyncScanKernel::AVX512
+    };
+
+    GeneratorConfig null_config;
+    null_config.pid = PID_NULL;
+    auto null_packet = gen.generatePacket(null_config);
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+    auto packet = gen.generatePacket(config);
+
+    for (size_t run = 0; run < 40; ++run) {
+        // run null packets followed by one program packet
+        std::vector<uint8_t> data;
+        for (size_t i = 0; i < run; ++i) {
+            data.insert(data.end(), null_packet.begin(), null_packet.end());
+        }
+        data.insert(data.end(), packet.begin(), packet.end());
+
+        const size_t count = run + 1;
+        for (SyncScanKernel kernel : kernels) {
+            if (!isSyncScanKernelSupported(kernel)) {
+                continue;
+            }
+            TEST_ASSERT_EQ(countNullPacketRun(kernel, data.data(), count), run,
+                          "Kernel should stop at the first program packet");
+            TEST_ASSERT_EQ(countNullPacketRun(kernel, data.data(), run), run,
+                          "Kernel should stop at the packet count");
+        }
+    }
+
+    return true;
+}
+
+// ============================================================================
+// Packet Format Detection
+// ============================================================================
+
+// Wrap 188-byte packets into M2TS (timestamp prefix) or RS (parity suffix) units
+static std::vector<uint8_t> wrapPackets(const std::vector<uint8_t>& packets,
+                                        PacketFormat format, PacketGenerator& gen) {
+    std::vector<uint8_t> result;
+    for (size_t pos = 0; pos + MPEGTS_PACKET_SIZE <= packets.size(); pos += MPEGTS_PACKET_SIZE) {
+        if (format == PacketFormat::M2TS) {
+            // Copy permission bits set: must be masked out of the timestamp
+            uint32_t header = 0xC0000000 | static_cast<uint32_t>(1000 * (pos / MPEGTS_PACKET_SIZE));
+            result.push_back(static_cast<uint8_t>(header >> 24));
+            result.push_back(static_cast<uint8_t>(header >> 16));
+            result.push_back(static_cast<uint8_t>(header >> 8));
+            result.push_back(static_cast<uint8_t>(header));
+        }
+
+        result.insert(result.end(), packets.begin() + pos,
+                      packets.begin() + pos + MPEGTS_PACKET_SIZE);
+
+        if (format == PacketFormat::TS_RS) {
+            auto parity = gen.generateGarbage(RS_PACKET_SIZE - MPEGTS_PACKET_SIZE, true);
+            result.insert(result.end(), parity.begin(), parity.end());
+        }
+    }
+    return result;
+}
+
+TEST(packet_format_detected_from_periodicity) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto packets = gen.generateSequence(10, config);
+    auto garbage = gen.generateGarbage(77, false);
+
+    const PacketFormat formats[] = {
+        PacketFormat::TS, PacketFormat::M2TS, PacketFormat::TS_RS
+    };
+
+    for (PacketFormat format : formats) {
+        auto data = garbage;
+        auto units = wrapPackets(packets, format, gen);
+        data.insert(data.end(), units.begin(), units.end());
+
+        TEST_ASSERT_TRUE(detectPacketFormat(data.data(), data.size()) == format,
+                        "Should detect the stride of the stream");
+    }
+
+    auto noise = gen.generateGarbage(2000, false);
+    TEST_ASSERT_TRUE(detectPacketFormat(noise.data(), noise.size()) == PacketFormat::AUTO,
+                    "Should not detect a format in noise");
+
+    return true;
+}
+
+TEST(m2ts_stream_demuxed_natively) {
+    PacketGenerator gen;
+    MPEGTSDemuxer demuxer;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto data = wrapPackets(gen.generateSequence(10, config), PacketFormat::M2TS, gen);
+
+    // Chunks that split both the timestamp and the packet
+    for (size_t pos = 0; pos < data.size(); pos += 100) {
+        demuxer.feedData(data.data() + pos, std::min<size_t>(100, data.size() - pos));
+    }
+
+    TEST_ASSERT_TRUE(demuxer.isSynchronized(), "Should sync on M2TS stream");
+    TEST_ASSERT_TRUE(demuxer.getPacketFormat() == PacketFormat::M2TS, "Should detect M2TS");
+    TEST_ASSERT_EQ(demuxer.getStats().packets_skipped, 0, "Should not skip packets");
+    TEST_ASSERT_EQ(countPackets(demuxer, 0x100), 10, "Should demux every packet");
+
+    auto iterations = demuxer.getIterationsSummary(0x100);
+    TEST_ASSERT_EQ(iterations.size(), 1, "Should have one iteration");
+
+    auto payloads = demuxer.getAllPayloads(0x100, iterations[0].iteration_id);
+    TEST_ASSERT_EQ(payloads.size(), 10, "Should have one payload per packet");
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        TEST_ASSERT_EQ(payloads[i].arrival_timestamp, 1000 * i,
+                      "Should expose the arrival timestamp of each packet");
+    }
+
+    return true;
+}
+
+TEST(rs_stream_demuxed_natively) {
+    PacketGenerator gen;
+
+    GeneratorConfig config;
+    config.pid = 0x100;
+
+    auto data = gen.generateGarbage(150, false);
+    auto units = wrapPackets(gen.generateSequence(12, config), PacketFormat::TS_RS, gen);
+    data.insert(data.end(), units.begin(), units.end());
+
+    // Forced format skips detection
+    DemuxerConfig demuxer_config;
+    demuxer_config.packet_format = PacketFormat::TS_RS;
+
+    MPEGTSDemuxer forced(demuxer_config);
+    forced.feedData(data.data(), data.size());
+
+    MPEGTSDemuxer detected;
+    detected.feedData(data.data(), data.size());
+
+    TEST_ASSERT_TRUE(detected.getPacketFormat() == PacketFormat::TS_RS, "Should detect RS");
+
+    for (const MPEGTSDemuxer* demuxer : {&forced, &detected}) {
+        TEST_ASSERT_TRUE(demuxer->isSynchronized(), "Should sync on RS stream");
+        TEST_ASSERT_EQ(demuxer->getStats().sync_losses, 0, "Should not lose lock");
+        TEST_ASSERT_EQ(countPackets(*demuxer, 0x100), 12, "Should demux every packet");
+    }
+
+    return true;
+}
+
 // ============================================================================
 // Main
 // ============================================================================